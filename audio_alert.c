@@ -0,0 +1,136 @@
+// Alert tone player on the pull-model render engine. A trigger thread
+// fires a short chime every few seconds; between chimes the stream is
+// silent and the engine idles. The run is made twice, with and without
+// idle suspension, to compare the CPU time spent.
+
+#include "irix_audio.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SAMPLE_RATE 44100
+#define BUFFER_SIZE 256
+#define RUN_SECONDS 8.0
+#define ALERT_INTERVAL 2.0      // Seconds between chimes
+#define ALERT_LENGTH 0.25       // Chime length, seconds
+#define PARTIALS 16             // Additive partials per chime (the render cost)
+
+typedef struct {
+    IrixAudioRender* render;
+    volatile unsigned int requested;    // Chimes asked for; written only by the trigger thread
+    unsigned int taken;                 // Chimes started; written only by the callback
+    volatile int running;
+    int remaining;              // Frames left in the current chime
+    double phase;
+} Alert;
+
+static int alert_callback(void* user, float* buffer, int frames) {
+    Alert* alert = (Alert*)user;
+    int length = (int)(ALERT_LENGTH * SAMPLE_RATE);
+
+    if (alert->remaining == 0 && alert->requested != alert->taken) {
+        alert->taken++;
+        alert->remaining = length;
+    }
+    // Like a mixer, the synth runs whether or not a chime is sounding
+    for (int i = 0; i < frames; i++) {
+        double env = 0.0;
+        float v = 0.0f;
+        if (alert->remaining > 0) {
+            env = (double)alert->remaining / length;
+            alert->remaining--;
+        }
+        for (int k = 1; k <= PARTIALS; k++) {
+            v += (float)(0.3 * env * sin(alert->phase * k) / k);
+        }
+        alert->phase += 2.0 * M_PI * 880.0 / SAMPLE_RATE;
+        buffer[i * 2] = v;
+        buffer[i * 2 + 1] = v;
+    }
+    return frames;
+}
+
+static void* trigger_thread(void* arg) {
+    Alert* alert = (Alert*)arg;
+    struct timespec interval;
+
+    interval.tv_sec = (time_t)ALERT_INTERVAL;
+    interval.tv_nsec = (long)((ALERT_INTERVAL - interval.tv_sec) * 1e9);
+    while (alert->running) {
+        nanosleep(&interval, NULL);
+        alert->requested++;
+        irix_audio_render_wake(alert->render);
+    }
+    return NULL;
+}
+
+static int run(int idle) {
+    IrixAudioStreamParams params = {
+        .mode = IRIX_AUDIO_OUTPUT,
+        .channels = 2,
+        .sample_rate = SAMPLE_RATE,
+        .buffer_size = BUFFER_SIZE,
+        .queue_size = 4 * BUFFER_SIZE
+    };
+    IrixAudioRenderParams render_params = {
+        .idle_periods = idle ? 0 : -1
+    };
+    Alert alert = {0};
+    pthread_t trigger;
+
+    IrixAudioStream* stream = irix_audio_open_stream(&params);
+    if (!stream) {
+        fprintf(stderr, "Failed to open stream: %s\n", irix_audio_get_last_error());
+        return -1;
+    }
+    alert.render = irix_audio_render_open(stream, alert_callback, &alert, &render_params);
+    if (!alert.render) {
+        fprintf(stderr, "Failed to open render engine: %s\n", irix_audio_get_last_error());
+        irix_audio_close_stream(stream);
+        return -1;
+    }
+
+    alert.running = 1;
+    pthread_create(&trigger, NULL, trigger_thread, &alert);
+
+    int periods = (int)(RUN_SECONDS * SAMPLE_RATE / BUFFER_SIZE);
+    clock_t cpu = clock();
+    for (int i = 0; i < periods; i++) {
+        if (irix_audio_render_process(alert.render) < 0) {
+            fprintf(stderr, "Render failed: %s\n", irix_audio_get_last_error());
+            break;
+        }
+    }
+    double cpu_ms = 1000.0 * (clock() - cpu) / CLOCKS_PER_SEC;
+
+    alert.running = 0;
+    pthread_join(trigger, NULL);
+
+    IrixAudioRenderStats stats;
+    irix_audio_render_get_stats(alert.render, &stats);
+    printf("  %-8s %8lu %8lu %8lu %8lu %6lu %10.1f\n", idle ? "idle" : "always",
+           stats.periods_rendered, stats.periods_silent, stats.periods_idle,
+           stats.idle_entries, stats.wakes, cpu_ms);
+
+    irix_audio_render_close(alert.render);
+    irix_audio_close_stream(stream);
+    return 0;
+}
+
+int main() {
+    if (irix_audio_initialize() < 0) {
+        fprintf(stderr, "Failed to initialize audio: %s\n", irix_audio_get_last_error());
+        return 1;
+    }
+
+    printf("Alert chimes every %.1f s for %.1f s\n", ALERT_INTERVAL, RUN_SECONDS);
+    printf("  %-8s %8s %8s %8s %8s %6s %10s\n", "mode", "rendered", "silent", "idle",
+           "entries", "wakes", "cpu ms");
+    int status = run(0);
+    if (status == 0) status = run(1);
+
+    irix_audio_cleanup();
+    return status < 0 ? 1 : 0;
+}
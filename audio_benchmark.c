@@ -0,0 +1,210 @@
+#include "irix_audio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <math.h>
+
+#define SAMPLE_RATE 44100
+#define BENCH_SECONDS 2.0   // audio processed per measurement
+
+static double now_seconds(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec * 1e-6;
+}
+
+// Fill a buffer with a two-tone test signal
+static void fill_signal(float* buffer, int frames, int channels) {
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            buffer[i * channels + c] = 0.4f * sinf(0.031f * i * (c + 1)) + 0.2f * sinf(0.17f * i);
+        }
+    }
+}
+
+// Build the reference chain: gain, 4-band EQ, compressor, channel matrix
+static IrixAudioChain* build_chain(int channels, int period) {
+    IrixAudioChain* chain = irix_audio_chain_create(channels, SAMPLE_RATE, period);
+    if (!chain) return NULL;
+
+    int gain = irix_audio_chain_add_gain(chain, -3.0, 20.0);
+    int eq = irix_audio_chain_add_eq(chain, 4);
+    irix_audio_chain_add_dynamics(chain, -12.0, 4.0, 5.0, 100.0, 3.0);
+    int matrix = irix_audio_chain_add_matrix(chain);
+    if (gain < 0 || eq < 0 || matrix < 0) {
+        irix_audio_chain_destroy(chain);
+        return NULL;
+    }
+
+    irix_audio_chain_set_eq_band(chain, eq, 0, IRIX_AUDIO_EQ_HIGH_PASS, 40.0, 0.707, 0.0);
+    irix_audio_chain_set_eq_band(chain, eq, 1, IRIX_AUDIO_EQ_LOW_SHELF, 120.0, 0.707, 3.0);
+    irix_audio_chain_set_eq_band(chain, eq, 2, IRIX_AUDIO_EQ_PEAK, 2500.0, 1.4, -4.0);
+    irix_audio_chain_set_eq_band(chain, eq, 3, IRIX_AUDIO_EQ_HIGH_SHELF, 8000.0, 0.707, 2.0);
+    if (channels > 1) {
+        irix_audio_chain_set_matrix(chain, matrix, 0, 1, 0.1);
+    }
+    return chain;
+}
+
+// Processing chain cost per channel per period
+static void bench_chain(void) {
+    int channel_counts[] = {1, 2, 8};
+    int periods[] = {64, 256, 1024};
+
+    printf("Processing chain (gain + 4-band EQ + compressor + matrix)\n");
+    printf("  %8s %8s %14s %14s\n", "channels", "period", "us/ch/period", "x realtime");
+
+    for (int i = 0; i < (int)(sizeof(channel_counts) / sizeof(channel_counts[0])); i++) {
+        for (int j = 0; j < (int)(sizeof(periods) / sizeof(periods[0])); j++) {
+            int channels = channel_counts[i];
+            int period = periods[j];
+            long iterations = (long)(BENCH_SECONDS * SAMPLE_RATE / period);
+
+            IrixAudioChain* chain = build_chain(channels, period);
+            float* buffer = malloc(period * channels * sizeof(float));
+            if (!chain || !buffer) {
+                fprintf(stderr, "Failed to set up chain: %s\n", irix_audio_get_last_error());
+                free(buffer);
+                irix_audio_chain_destroy(chain);
+                return;
+            }
+
+            double elapsed = 0.0;
+            for (long k = 0; k < iterations; k++) {
+                // Regenerate the input so the chain never settles into silence
+                fill_signal(buffer, period, channels);
+                double start = now_seconds();
+                irix_audio_chain_process(chain, buffer, period);
+                elapsed += now_seconds() - start;
+            }
+
+            double per_period = elapsed / iterations;
+            printf("  %8d %8d %14.3f %14.1f\n", channels, period,
+                   per_period * 1e6 / channels, BENCH_SECONDS / elapsed);
+
+            free(buffer);
+            irix_audio_chain_destroy(chain);
+        }
+    }
+}
+
+// Convolution cost for a long stereo impulse response
+static void bench_convolver(void) {
+    int ir_frames = 3 * SAMPLE_RATE;
+    int channels = 2;
+    int period = 256;
+    int tails[] = {0, 4096, 8192};
+
+    float* ir = malloc(ir_frames * channels * sizeof(float));
+    float* buffer = malloc(period * channels * sizeof(float));
+    if (!ir || !buffer) {
+        free(ir);
+        free(buffer);
+        return;
+    }
+    // Decaying noise, like a room response
+    for (int i = 0; i < ir_frames * channels; i++) {
+        ir[i] = ((float)rand() / RAND_MAX - 0.5f) * expf(-(float)(i / channels) / (0.5f * SAMPLE_RATE));
+    }
+
+    printf("Convolution (3 s stereo IR, period %d)\n", period);
+    printf("  %8s %10s %10s %14s %14s\n", "tail", "head parts", "tail parts", "us/ch/period", "x realtime");
+
+    for (int i = 0; i < (int)(sizeof(tails) / sizeof(tails[0])); i++) {
+        IrixAudioConvolverParams params = {
+            .block_frames = period,
+            .tail_block_frames = tails[i],
+            .background = 0
+        };
+        IrixAudioConvolver* conv = irix_audio_convolver_create(channels, ir, ir_frames, channels, &params);
+        if (!conv) {
+            fprintf(stderr, "Failed to create convolver: %s\n", irix_audio_get_last_error());
+            break;
+        }
+
+        long iterations = (long)(BENCH_SECONDS * SAMPLE_RATE / period);
+        double elapsed = 0.0;
+        for (long k = 0; k < iterations; k++) {
+            fill_signal(buffer, period, channels);
+            double start = now_seconds();
+            irix_audio_convolver_process(conv, buffer, period);
+            elapsed += now_seconds() - start;
+        }
+
+        IrixAudioConvolverStats stats;
+        irix_audio_convolver_get_stats(conv, &stats);
+        printf("  %8d %10d %10d %14.3f %14.1f\n", tails[i], stats.head_partitions,
+               stats.tail_partitions, elapsed / iterations * 1e6 / channels, BENCH_SECONDS / elapsed);
+        irix_audio_convolver_destroy(conv);
+    }
+
+    free(ir);
+    free(buffer);
+}
+
+// Lossless capture throughput and compression for a stereo 24-bit signal
+static void bench_capture(void) {
+    int worker_counts[] = {1, 2, 4};
+    int channels = 2;
+    int period = 256;
+    long total_frames = (long)(10 * BENCH_SECONDS * SAMPLE_RATE) / period * period;
+
+    // Generate the input up front so only capture and encoding are timed
+    float* signal = malloc(total_frames * channels * sizeof(float));
+    if (!signal) return;
+    fill_signal(signal, total_frames, channels);
+    for (long j = 0; j < total_frames * channels; j++) {
+        // Low-level noise so the encoder sees a realistic signal
+        signal[j] += ((float)rand() / RAND_MAX - 0.5f) * 1e-4f;
+    }
+
+    printf("Lossless capture (stereo 24-bit, %.0f s of audio)\n", 10 * BENCH_SECONDS);
+    printf("  %8s %10s %14s %14s\n", "workers", "ratio", "frames/s", "x realtime");
+
+    for (int i = 0; i < (int)(sizeof(worker_counts) / sizeof(worker_counts[0])); i++) {
+        // Queue holds the whole run so the measurement sees no drops
+        IrixAudioCaptureParams params = {
+            .path = "benchmark.flac",
+            .channels = channels,
+            .sample_rate = SAMPLE_RATE,
+            .bits_per_sample = 24,
+            .block_frames = 4096,
+            .queue_blocks = (int)(total_frames / 4096) + 2,
+            .workers = worker_counts[i]
+        };
+
+        double start = now_seconds();
+        IrixAudioCapture* cap = irix_audio_capture_open(&params);
+        if (!cap) {
+            fprintf(stderr, "Failed to open capture: %s\n", irix_audio_get_last_error());
+            break;
+        }
+        for (long k = 0; k < total_frames; k += period) {
+            irix_audio_capture_write(cap, signal + k * channels, period);
+        }
+        irix_audio_capture_close(cap);
+        double elapsed = now_seconds() - start;
+
+        // Compare the finished file against 24-bit PCM
+        double ratio = 0.0;
+        FILE* file = fopen("benchmark.flac", "rb");
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            long size = ftell(file);
+            if (size > 0) ratio = (double)total_frames * channels * 3 / size;
+            fclose(file);
+        }
+        printf("  %8d %10.2f %14.0f %14.1f\n", worker_counts[i], ratio,
+               total_frames / elapsed, total_frames / (double)SAMPLE_RATE / elapsed);
+    }
+
+    remove("benchmark.flac");
+    free(signal);
+}
+
+int main() {
+    bench_chain();
+    bench_convolver();
+    bench_capture();
+    return 0;
+}
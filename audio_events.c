@@ -0,0 +1,205 @@
+// Sample-accurate events: a click track with large periods. Each click is
+// a callback event at an exact frame, a chain gain event drops the level
+// halfway through, and markers report back each click's frame. On the
+// simulated device the output is read back through the loopback and the
+// click spacing and levels are checked frame for frame. The run is made
+// twice, the second time with a convolver after the gain stage: the event
+// splits hand it pieces of any length, and its delayed impulse response
+// must move every click by the same number of frames.
+
+#include "irix_audio.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLE_RATE 44100
+#define BUFFER_SIZE 2048
+#define CLICKS 8
+#define CLICK_START 3000        // Frame of the first click
+#define CLICK_SPACING 5513      // Frames between clicks, not a multiple of the period
+#define CLICK_LEVEL 0.8f
+#define GAIN_STEP_DB -6.0       // Applied from the click halfway through
+#define CONV_BLOCK 256          // Convolver partition, smaller than the period
+#define CONV_DELAY 300          // Impulse response: a unit impulse this many frames in
+
+typedef struct {
+    volatile int click;         // Set by the click event, taken by the render callback
+} Clicker;
+
+static void click_event(void* user, const IrixAudioEvent* event) {
+    (void)event;
+    ((Clicker*)user)->click = 1;
+}
+
+// Render a one-frame click at the start of the piece after a click event
+static int click_render(void* user, float* buffer, int frames) {
+    Clicker* clicker = (Clicker*)user;
+
+    for (int i = 0; i < frames; i++) buffer[i] = 0.0f;
+    if (clicker->click) {
+        buffer[0] = CLICK_LEVEL;
+        clicker->click = 0;
+    }
+    return frames;
+}
+
+static int run(int convolve) {
+    IrixAudioStreamParams output_params = {
+        .mode = IRIX_AUDIO_OUTPUT,
+        .channels = 1,
+        .sample_rate = SAMPLE_RATE,
+        .buffer_size = BUFFER_SIZE,
+        .queue_size = 2 * BUFFER_SIZE
+    };
+    IrixAudioStreamParams input_params = output_params;
+    input_params.mode = IRIX_AUDIO_INPUT;
+    input_params.queue_size = 8 * BUFFER_SIZE;
+    Clicker clicker = {0};
+    IrixAudioRender* render = NULL;
+    IrixAudioConvolver* conv = NULL;
+    float* capture = NULL;
+    int periods = (CLICK_START + CLICKS * CLICK_SPACING) / BUFFER_SIZE + 8;
+    int status = 1;
+
+    IrixAudioStream* output = irix_audio_open_stream(&output_params);
+    IrixAudioStream* input = irix_audio_open_stream(&input_params);
+    IrixAudioChain* chain = irix_audio_chain_create(1, SAMPLE_RATE, BUFFER_SIZE);
+    IrixAudioEvents* events = irix_audio_events_create(64);
+    if (!output || !input || !chain || !events) {
+        fprintf(stderr, "Setup failed: %s\n", irix_audio_get_last_error());
+        goto cleanup;
+    }
+
+    // A zero-length ramp makes the gain change a step on its frame
+    int gain_node = irix_audio_chain_add_gain(chain, 0.0, 0.0);
+    if (convolve) {
+        float ir[CONV_DELAY + 1] = {0};
+        IrixAudioConvolverParams conv_params = { .block_frames = CONV_BLOCK };
+        ir[CONV_DELAY] = 1.0f;
+        conv = irix_audio_convolver_create(1, ir, CONV_DELAY + 1, 1, &conv_params);
+        if (!conv || irix_audio_chain_add_convolver(chain, conv) < 0) {
+            fprintf(stderr, "Failed to add convolver: %s\n", irix_audio_get_last_error());
+            goto cleanup;
+        }
+        printf("With a convolver (block %d, impulse at %d frames):\n", CONV_BLOCK, CONV_DELAY);
+    } else {
+        printf("With a gain stage:\n");
+    }
+    irix_audio_chain_attach(output, chain);
+    irix_audio_events_attach(output, events);
+    IrixAudioRenderParams render_params = { .idle_periods = -1 };
+    render = irix_audio_render_open(output, click_render, &clicker, &render_params);
+    if (!render) {
+        fprintf(stderr, "Failed to open render engine: %s\n", irix_audio_get_last_error());
+        goto cleanup;
+    }
+
+    // Keep a period of lead on the output; the loop below reads in lock step
+    capture = calloc((size_t)periods * BUFFER_SIZE, sizeof(float));
+    if (!capture || irix_audio_write_frames(output, capture, BUFFER_SIZE) < 0) {
+        fprintf(stderr, "Failed to prime output: %s\n", irix_audio_get_last_error());
+        goto cleanup;
+    }
+
+    // Schedule everything up front, relative to the current position
+    long long origin = irix_audio_get_position(output);
+    for (int i = 0; i < CLICKS; i++) {
+        IrixAudioEvent event = {0};
+        event.frame = origin + CLICK_START + (long long)i * CLICK_SPACING;
+        event.id = i;
+        event.type = IRIX_AUDIO_EVENT_CALLBACK;
+        event.callback = click_event;
+        event.user = &clicker;
+        irix_audio_events_post(events, &event);
+        event.type = IRIX_AUDIO_EVENT_MARKER;
+        irix_audio_events_post(events, &event);
+        if (i == CLICKS / 2) {
+            IrixAudioEvent gain = {0};
+            gain.frame = event.frame;
+            gain.type = IRIX_AUDIO_EVENT_GAIN;
+            gain.node = gain_node;
+            gain.gain_db = GAIN_STEP_DB;
+            irix_audio_events_post(events, &gain);
+        }
+    }
+
+    // Run past the last click and the loopback delay, capturing the input
+    for (int p = 0; p < periods; p++) {
+        if (irix_audio_render_process(render) < 0 ||
+            irix_audio_read_frames(input, capture + (size_t)p * BUFFER_SIZE, BUFFER_SIZE) < 0) {
+            fprintf(stderr, "I/O failed: %s\n", irix_audio_get_last_error());
+            goto cleanup;
+        }
+    }
+
+    IrixAudioEvent marker;
+    printf("Markers (period %d frames):\n", BUFFER_SIZE);
+    while (irix_audio_events_poll(events, &marker) > 0) {
+        long long offset = marker.frame - origin;
+        printf("  click %d at frame %lld (period %lld, offset %lld)\n", marker.id, offset,
+               offset / BUFFER_SIZE, offset % BUFFER_SIZE);
+    }
+
+    IrixAudioEventStats stats;
+    irix_audio_events_get_stats(events, &stats);
+    printf("Events: %lu posted, %lu applied, %lu late, %lu dropped\n",
+           stats.posted, stats.applied, stats.late, stats.dropped);
+    status = (stats.applied == stats.posted && stats.late == 0) ? 0 : 1;
+
+#ifdef IRIX_AUDIO_SIMULATE
+    // Find the clicks in the loopback and compare spacing and level
+    {
+        int found = 0, first = -1;
+        float low = CLICK_LEVEL * (float)pow(10.0, GAIN_STEP_DB / 20.0);
+        for (int i = 0; i < periods * BUFFER_SIZE && found < CLICKS; i++) {
+            if (fabsf(capture[i]) < low / 2) continue;
+            if (first < 0) first = i;
+            float expected = (found >= CLICKS / 2) ? low : CLICK_LEVEL;
+            int spacing_ok = (i - first == found * CLICK_SPACING);
+            int level_ok = fabsf(capture[i] - expected) < 1e-4f;
+            printf("  loopback click %d at +%d level %.3f %s\n", found, i - first, capture[i],
+                   (spacing_ok && level_ok) ? "ok" : "FAIL");
+            if (!spacing_ok || !level_ok) status = 1;
+            found++;
+        }
+        if (found != CLICKS) {
+            printf("  found %d of %d clicks in the loopback: FAIL\n", found, CLICKS);
+            status = 1;
+        }
+    }
+#endif
+
+cleanup:
+    free(capture);
+    irix_audio_render_close(render);
+    if (output) {
+        irix_audio_events_attach(output, NULL);
+        irix_audio_chain_attach(output, NULL);
+    }
+    irix_audio_events_destroy(events);
+    irix_audio_chain_destroy(chain);
+    irix_audio_convolver_destroy(conv);
+    irix_audio_close_stream(input);
+    irix_audio_close_stream(output);
+    return status;
+}
+
+int main() {
+    int status;
+
+    if (irix_audio_initialize() < 0) {
+        fprintf(stderr, "Failed to initialize audio: %s\n", irix_audio_get_last_error());
+        return 1;
+    }
+
+#ifdef IRIX_AUDIO_SIMULATE
+    // Keep the loopback delay whole so each click stays a single frame
+    irix_audio_sim_set_delay(floor(irix_audio_sim_get_delay()));
+#endif
+
+    status = run(0);
+    status |= run(1);
+
+    irix_audio_cleanup();
+    return status;
+}
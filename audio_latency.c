@@ -0,0 +1,100 @@
+#include "irix_audio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define QUEUE_PERIODS 4         // Port queue size, in periods, for the sweep
+#define SIM_DELAY 37.25         // Simulated external delay, in frames
+#define SIM_TOLERANCE 0.1       // Largest accepted error against it, in frames
+
+// Measure one configuration; returns 1 if it was measured (and, on the
+// simulated device, matched the configured delay), 0 if not, -1 on error
+static int measure(int rate, int buffer_size, int queue_size) {
+    IrixAudioStreamParams output_params = {
+        .mode = IRIX_AUDIO_OUTPUT,
+        .channels = 1,
+        .sample_rate = rate,
+        .buffer_size = buffer_size,
+        .queue_size = queue_size
+    };
+    IrixAudioStreamParams input_params = output_params;
+    input_params.mode = IRIX_AUDIO_INPUT;
+
+    IrixAudioStream* output = irix_audio_open_stream(&output_params);
+    IrixAudioStream* input = irix_audio_open_stream(&input_params);
+    if (!output || !input) {
+        fprintf(stderr, "Failed to open streams: %s\n", irix_audio_get_last_error());
+        if (output) irix_audio_close_stream(output);
+        if (input) irix_audio_close_stream(input);
+        return -1;
+    }
+
+    IrixAudioLatencyResult result;
+    int status = irix_audio_measure_latency(output, input, NULL, &result);
+    irix_audio_close_stream(input);
+    irix_audio_close_stream(output);
+    if (status < 0) {
+        // Usually xruns: the configuration cannot hold a steady round trip
+        printf("  %6d %6d %6d  %s\n", rate, buffer_size, queue_size, irix_audio_get_last_error());
+        return 0;
+    }
+
+    double ms = 1000.0 / rate;
+    printf("  %6d %6d %6d %10.2f %9.2f %9.2f %9.2f %9.2f %7.1f %5d",
+           rate, buffer_size, queue_size, result.round_trip_frames, result.round_trip_frames * ms,
+           result.output_frames * ms, result.input_frames * ms, result.external_frames * ms,
+           result.snr_db, result.restarts);
+
+#ifdef IRIX_AUDIO_SIMULATE
+    // The simulated device's only external delay is the configured one
+    double error = result.external_frames - irix_audio_sim_get_delay();
+    int passed = fabs(error) <= SIM_TOLERANCE;
+    printf("  %+.3f %s\n", error, passed ? "ok" : "FAIL");
+    return passed ? 1 : -1;
+#else
+    printf("\n");
+    return 1;
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    int rates[] = {22050, 44100, 48000};
+    int buffer_sizes[] = {64, 128, 256, 512, 1024};
+    int measured = 0, failures = 0;
+
+    if (irix_audio_initialize() < 0) {
+        fprintf(stderr, "Failed to initialize audio: %s\n", irix_audio_get_last_error());
+        return 1;
+    }
+
+#ifdef IRIX_AUDIO_SIMULATE
+    // Validate against a known delay unless one was set in the environment
+    if (!getenv("IRIX_AUDIO_SIM_DELAY")) irix_audio_sim_set_delay(SIM_DELAY);
+    printf("Simulated device, external delay %.3f frames\n", irix_audio_sim_get_delay());
+#endif
+
+    printf("Round-trip latency (times in ms)\n");
+    printf("  %6s %6s %6s %10s %9s %9s %9s %9s %7s %5s\n",
+           "rate", "buffer", "queue", "frames", "total", "output", "input", "external", "snr dB", "xrun");
+
+    if (argc > 1) {
+        // Single configuration: audio_latency rate [buffer_size [queue_size]]
+        int rate = atoi(argv[1]);
+        int buffer_size = (argc > 2) ? atoi(argv[2]) : 256;
+        int queue_size = (argc > 3) ? atoi(argv[3]) : QUEUE_PERIODS * buffer_size;
+        int result = measure(rate, buffer_size, queue_size);
+        if (result < 0) failures++;
+        if (result > 0) measured++;
+    } else {
+        for (int i = 0; i < (int)(sizeof(rates) / sizeof(rates[0])); i++) {
+            for (int j = 0; j < (int)(sizeof(buffer_sizes) / sizeof(buffer_sizes[0])); j++) {
+                int result = measure(rates[i], buffer_sizes[j], QUEUE_PERIODS * buffer_sizes[j]);
+                if (result < 0) failures++;
+                if (result > 0) measured++;
+            }
+        }
+    }
+
+    irix_audio_cleanup();
+    return (failures || !measured) ? 1 : 0;
+}
@@ -2,12 +2,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #define SAMPLE_RATE 44100
 #define BUFFER_SIZE 256
 #define LOOPBACK_DURATION 5.0  // seconds
+#define SIM_SKEW_PPM 300.0      // Clock offset injected on the simulated device
+#define SKEW_TOLERANCE_PPM 30.0 // Largest final drift error accepted on the simulator
+
+int main(int argc, char *argv[]) {
+    double duration = (argc > 1) ? atof(argv[1]) : LOOPBACK_DURATION;
+    int status = 0;
 
-int main() {
     // Initialize audio system
     int device_count = irix_audio_initialize();
     if (device_count < 0) {
@@ -16,6 +22,13 @@ int main() {
     }
     printf("Found %d audio devices\n", device_count);
 
+#ifdef IRIX_AUDIO_SIMULATE
+    // Give the output its own clock so the bridge has real drift to track
+    double skew_ppm = (argc > 2) ? atof(argv[2]) : SIM_SKEW_PPM;
+    irix_audio_sim_set_rate_skew(skew_ppm);
+    printf("Simulated output clock offset %+.1f ppm\n", skew_ppm);
+#endif
+
     // Prepare input stream parameters
     IrixAudioStreamParams input_params = {
         .mode = IRIX_AUDIO_INPUT,
@@ -45,35 +58,59 @@ int main() {
         return 1;
     }
 
-    // Prepare buffers
-    float input_buffer[BUFFER_SIZE];
-    float output_buffer[BUFFER_SIZE];
-    int total_frames = (int)(LOOPBACK_DURATION * SAMPLE_RATE);
+    // Bridge input to output, compensating for clock drift between them; the
+    // loop is wider than the default so it settles within a short run
+    IrixAudioBridgeParams bridge_params = {
+        .target_latency_frames = 2 * BUFFER_SIZE,
+        .period_frames = BUFFER_SIZE,
+        .bandwidth_hz = 0.2
+    };
+    IrixAudioBridge* bridge = irix_audio_bridge_open(input_stream, output_stream, &bridge_params);
+    if (!bridge) {
+        fprintf(stderr, "Failed to open bridge: %s\n", irix_audio_get_last_error());
+        irix_audio_close_stream(input_stream);
+        irix_audio_close_stream(output_stream);
+        return 1;
+    }
+
+    IrixAudioBridgeStats stats;
+    int total_frames = (int)(duration * SAMPLE_RATE);
     int frames_processed = 0;
+    int next_report = SAMPLE_RATE;
 
-    printf("Starting audio loopback test for %.2f seconds...\n", LOOPBACK_DURATION);
+    printf("Starting audio loopback test for %.2f seconds...\n", duration);
 
     while (frames_processed < total_frames) {
-        // Determine how many frames to process
-        int read_count = (total_frames - frames_processed < BUFFER_SIZE) ? 
-                         total_frames - frames_processed : BUFFER_SIZE;
-
-        // Read input
-        int read_result = irix_audio_read_frames(input_stream, input_buffer, read_count);
-        if (read_result < 0) {
-            fprintf(stderr, "Error reading input frames: %s\n", irix_audio_get_last_error());
+        int result = irix_audio_bridge_process(bridge);
+        if (result < 0) {
+            fprintf(stderr, "Error in loopback bridge: %s\n", irix_audio_get_last_error());
             break;
         }
+        frames_processed += result;
 
-        // Immediately write input back to output (loopback)
-        int write_result = irix_audio_write_frames(output_stream, input_buffer, read_result);
-        if (write_result < 0) {
-            fprintf(stderr, "Error writing output frames: %s\n", irix_audio_get_last_error());
-            break;
+        // Report drift and latency once per second
+        if (frames_processed >= next_report) {
+            irix_audio_bridge_get_stats(bridge, &stats);
+            printf("  drift %+.1f ppm, latency %.1f frames (min %.0f, max %.0f, rms error %.1f)\n",
+                   stats.drift_ppm, stats.latency_frames, stats.latency_min_frames,
+                   stats.latency_max_frames, stats.latency_error_rms);
+            irix_audio_bridge_reset_stats(bridge);
+            next_report += SAMPLE_RATE;
         }
+    }
 
-        frames_processed += read_result;
+    irix_audio_bridge_get_stats(bridge, &stats);
+    printf("Output %lu frames for %lu input frames, %lu underflows\n",
+           stats.frames_out, stats.frames_in, stats.underflows);
+#ifdef IRIX_AUDIO_SIMULATE
+    {
+        int ok = fabs(stats.drift_ppm - skew_ppm) <= SKEW_TOLERANCE_PPM;
+        printf("Drift estimate %+.1f ppm for an offset of %+.1f ppm: %s\n", stats.drift_ppm, skew_ppm,
+               ok ? "ok" : "FAIL");
+        if (!ok) status = 1;
     }
+#endif
+    irix_audio_bridge_close(bridge);
 
     // Cleanup
     irix_audio_close_stream(input_stream);
@@ -81,5 +118,5 @@ int main() {
     irix_audio_cleanup();
 
     printf("Loopback test completed. Processed %d frames.\n", frames_processed);
-    return 0;
+    return status;
 }
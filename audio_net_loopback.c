@@ -0,0 +1,145 @@
+#include "irix_audio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SAMPLE_RATE 44100
+#define CHANNELS 2
+#define PACKET_FRAMES 256
+#define NET_PORT 15004
+#define FREQUENCY 440.0
+#define DEFAULT_DURATION 10.0  // seconds
+#define CONCEAL_MARGIN 3.0      // Concealment allowed beyond the simulated loss, percent
+
+void usage(void) {
+    fprintf(stderr, "\nusage: audio_net_loopback <loss> <jitter_ms> <seconds>\n");
+    fprintf(stderr, "    where loss = simulated packet loss in percent (default = 0),\n");
+    fprintf(stderr, "    jitter_ms = simulated arrival jitter (default = 0),\n");
+    fprintf(stderr, "    and seconds = test duration (default = %.0f).\n\n", DEFAULT_DURATION);
+    exit(EXIT_FAILURE);
+}
+
+static void print_stats(const char* label, IrixAudioNetStats* stats) {
+    printf("%s: recv %lu lost %lu late %lu skipped %lu inserted %lu underruns %lu concealed %lu "
+           "jitter %.1f target %d latency %d frames\n",
+           label, stats->packets_received, stats->packets_lost, stats->packets_late,
+           stats->packets_skipped, stats->packets_inserted, stats->underruns, stats->frames_concealed,
+           stats->jitter_frames, stats->target_latency_frames, stats->current_latency_frames);
+}
+
+int main(int argc, char *argv[]) {
+    double loss = 0.0, jitter_ms = 0.0, duration = DEFAULT_DURATION;
+    float send_buffer[PACKET_FRAMES * CHANNELS];
+    IrixAudioNetStats stats;
+    long packets, i;
+    int j, c, status = 0;
+
+    if (argc > 4) usage();
+    if (argc > 1) loss = atof(argv[1]);
+    if (argc > 2) jitter_ms = atof(argv[2]);
+    if (argc > 3) duration = atof(argv[3]);
+
+    // Receiver with simulated impairment
+    IrixAudioNetParams receive_params = {
+        .direction = IRIX_AUDIO_NET_RECEIVE,
+        .host = "127.0.0.1",
+        .port = NET_PORT,
+        .channels = CHANNELS,
+        .sample_rate = SAMPLE_RATE,
+        .packet_frames = PACKET_FRAMES,
+        .max_latency_frames = SAMPLE_RATE,
+        .loss_rate = loss / 100.0,
+        .jitter_frames = (int)(jitter_ms * SAMPLE_RATE / 1000.0)
+    };
+
+    // Sender over localhost
+    IrixAudioNetParams send_params = {
+        .direction = IRIX_AUDIO_NET_SEND,
+        .host = "127.0.0.1",
+        .port = NET_PORT,
+        .channels = CHANNELS,
+        .sample_rate = SAMPLE_RATE,
+        .packet_frames = PACKET_FRAMES
+    };
+
+    // The receiver plays out through an output stream, whose blocking
+    // writes pace both ends at the sample rate
+    IrixAudioStreamParams output_params = {
+        .mode = IRIX_AUDIO_OUTPUT,
+        .channels = CHANNELS,
+        .sample_rate = SAMPLE_RATE,
+        .buffer_size = PACKET_FRAMES,
+        .queue_size = 4 * PACKET_FRAMES
+    };
+
+    if (irix_audio_initialize() < 0) {
+        fprintf(stderr, "Failed to initialize audio: %s\n", irix_audio_get_last_error());
+        return 1;
+    }
+
+    IrixAudioStream* output = irix_audio_open_stream(&output_params);
+    IrixAudioNet* receiver = irix_audio_net_open(&receive_params);
+    IrixAudioNet* sender = irix_audio_net_open(&send_params);
+    if (!output || !receiver || !sender || irix_audio_net_attach(output, receiver) < 0) {
+        fprintf(stderr, "Setup failed: %s\n", irix_audio_get_last_error());
+        irix_audio_net_close(sender);
+        irix_audio_net_close(receiver);
+        irix_audio_close_stream(output);
+        irix_audio_cleanup();
+        return 1;
+    }
+
+    printf("Streaming over localhost for %.2f seconds (loss %.1f%%, jitter %.1f ms)...\n",
+           duration, loss, jitter_ms);
+
+    packets = (long)(duration * SAMPLE_RATE / PACKET_FRAMES);
+    for (i = 0; i < packets; i++) {
+        // Generate one packet of sine wave
+        for (j = 0; j < PACKET_FRAMES; j++) {
+            float value = 0.5f * sinf(2.0f * M_PI * FREQUENCY * (i * PACKET_FRAMES + j) / SAMPLE_RATE);
+            for (c = 0; c < CHANNELS; c++) {
+                send_buffer[j * CHANNELS + c] = value;
+            }
+        }
+
+        if (irix_audio_net_send(sender, send_buffer, PACKET_FRAMES) < 0) {
+            fprintf(stderr, "Error sending: %s\n", irix_audio_get_last_error());
+            break;
+        }
+
+        if (irix_audio_net_pump(output, PACKET_FRAMES) < 0) {
+            fprintf(stderr, "Error playing: %s\n", irix_audio_get_last_error());
+            break;
+        }
+
+        if ((i + 1) % (SAMPLE_RATE / PACKET_FRAMES) == 0) {
+            irix_audio_net_get_stats(receiver, &stats);
+            print_stats("  ", &stats);
+        }
+    }
+
+    irix_audio_net_get_stats(receiver, &stats);
+    printf("Sent %ld packets\n", i);
+    print_stats("Final", &stats);
+
+    // On a jittery but lossless link the buffer should absorb the jitter;
+    // concealing much more than the simulated loss means it did not
+    if (i > 0) {
+        double concealed = 100.0 * stats.frames_concealed / ((double)i * PACKET_FRAMES);
+        int ok = concealed <= loss + CONCEAL_MARGIN;
+        printf("Concealed %.1f%% of the output (loss %.1f%%): %s\n", concealed, loss,
+               ok ? "ok" : "FAIL");
+        if (!ok) status = 1;
+    }
+
+#ifdef IRIX_AUDIO_SIMULATE
+    printf("Device xruns: %lu\n", irix_audio_sim_get_xruns());
+#endif
+
+    irix_audio_net_attach(output, NULL);
+    irix_audio_net_close(sender);
+    irix_audio_net_close(receiver);
+    irix_audio_close_stream(output);
+    irix_audio_cleanup();
+    return status;
+}
@@ -1,12 +1,24 @@
 #include "irix_audio.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define SAMPLE_RATE 44100
 #define BUFFER_SIZE 256
 #define RECORD_DURATION 5.0  // seconds
 
-int main() {
+void usage(void) {
+    fprintf(stderr, "\nusage: audio_recorder [-raw]\n");
+    fprintf(stderr, "    where -raw also writes the float samples to recording.raw.\n\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    int write_raw = 0;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "-raw") != 0)) usage();
+    if (argc == 2) write_raw = 1;
+
     // Initialize audio system
     int device_count = irix_audio_initialize();
     if (device_count < 0) {
@@ -51,12 +63,29 @@ int main() {
     int total_frames = (int)(RECORD_DURATION * SAMPLE_RATE);
     int frames_read = 0;
 
-    // Open output file
-    FILE* output_file = fopen("recording.raw", "wb");
-    if (!output_file) {
-        fprintf(stderr, "Failed to open output file\n");
-        irix_audio_close_stream(stream);
-        return 1;
+    // Open the raw output file if asked for
+    FILE* output_file = NULL;
+    if (write_raw) {
+        output_file = fopen("recording.raw", "wb");
+        if (!output_file) {
+            fprintf(stderr, "Failed to open output file\n");
+            irix_audio_close_stream(stream);
+            return 1;
+        }
+    }
+
+    // Encode a lossless copy in the background as frames are read
+    IrixAudioCaptureParams capture_params = {
+        .path = "recording.flac",
+        .channels = params.channels,
+        .sample_rate = SAMPLE_RATE,
+        .bits_per_sample = 24
+    };
+    IrixAudioCapture* capture = irix_audio_capture_open(&capture_params);
+    if (!capture || irix_audio_capture_attach(stream, capture) < 0) {
+        fprintf(stderr, "Lossless capture disabled: %s\n", irix_audio_get_last_error());
+        if (capture) irix_audio_capture_close(capture);
+        capture = NULL;
     }
 
     printf("Recording for %.2f seconds...\n", RECORD_DURATION);
@@ -73,15 +102,33 @@ int main() {
         }
         
         // Write to file
-        fwrite(buffer, sizeof(float), result, output_file);
+        if (output_file) fwrite(buffer, sizeof(float), result, output_file);
         frames_read += result;
     }
 
+    printf("Recorded %d frames\n", frames_read);
+    if (output_file) {
+        fclose(output_file);
+        printf("Wrote recording.raw\n");
+    }
+
+    // Finish the FLAC file before reading its statistics, so they count
+    // the final partial block
+    if (capture) {
+        IrixAudioCaptureStats stats;
+        irix_audio_capture_attach(stream, NULL);
+        if (irix_audio_capture_finish(capture) < 0) {
+            fprintf(stderr, "Error finishing recording.flac: %s\n", irix_audio_get_last_error());
+        } else {
+            irix_audio_capture_get_stats(capture, &stats);
+            printf("Encoded recording.flac (ratio %.2f, %llu frames dropped)\n",
+                   stats.compression_ratio, stats.frames_dropped);
+        }
+        irix_audio_capture_close(capture);
+    }
+
     // Cleanup
-    fclose(output_file);
     irix_audio_close_stream(stream);
     irix_audio_cleanup();
-
-    printf("Recorded %d frames to recording.raw\n", frames_read);
     return 0;
 }
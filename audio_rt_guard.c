@@ -0,0 +1,124 @@
+// Real-time guard demonstration. An I/O thread enables real-time mode on
+// an output stream and plays a tone from the preallocated period buffer,
+// but allocates a scratch buffer on one period. In a library built with
+// -DIRIX_AUDIO_RT_DEBUG the guard catches that allocation; the program
+// prints the report and checks it names exactly that call.
+
+#include "irix_audio.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLE_RATE 44100
+#define CHANNELS 2
+#define BUFFER_SIZE 256
+#define PERIODS 200
+#define MALLOC_PERIOD 10        // Period on which the I/O thread allocates
+
+typedef struct {
+    IrixAudioStream* stream;
+    float* scratch;             // The offending allocation, freed by main
+    int enabled;
+    int failed;
+} Player;
+
+static void* io_thread(void* arg) {
+    Player* player = (Player*)arg;
+    IrixAudioRtParams rt;
+    float* buffer;
+    double phase = 0.0;
+    int period, i;
+
+    // Guard only: memory locking and SCHED_FIFO need privileges
+    memset(&rt, 0, sizeof(rt));
+    rt.flags = IRIX_AUDIO_RT_GUARD;
+    player->enabled = (irix_audio_rt_enable(player->stream, &rt) == 0);
+    if (!player->enabled) return NULL;
+    buffer = (float*)irix_audio_rt_buffer(player->stream);
+
+    for (period = 0; period < PERIODS; period++) {
+        if (period == MALLOC_PERIOD) {
+            // The mistake the guard is there to catch
+            player->scratch = malloc(BUFFER_SIZE * CHANNELS * sizeof(float));
+        }
+        for (i = 0; i < BUFFER_SIZE; i++) {
+            float v = (float)(0.3 * sin(phase));
+            buffer[i * CHANNELS] = v;
+            buffer[i * CHANNELS + 1] = v;
+            phase += 2.0 * M_PI * 440.0 / SAMPLE_RATE;
+        }
+        if (irix_audio_write_frames(player->stream, buffer, BUFFER_SIZE) < 0) {
+            player->failed = 1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    IrixAudioStreamParams params;
+    IrixAudioRtReport report;
+    Player player;
+    pthread_t thread;
+    int status = 0;
+
+    if (irix_audio_initialize() < 0) {
+        fprintf(stderr, "Failed to initialize audio: %s\n", irix_audio_get_last_error());
+        return 1;
+    }
+
+    memset(&params, 0, sizeof(params));
+    params.mode = IRIX_AUDIO_OUTPUT;
+    params.channels = CHANNELS;
+    params.sample_rate = SAMPLE_RATE;
+    params.buffer_size = BUFFER_SIZE;
+    params.queue_size = 4 * BUFFER_SIZE;
+
+    memset(&player, 0, sizeof(player));
+    player.stream = irix_audio_open_stream(&params);
+    if (!player.stream) {
+        fprintf(stderr, "Failed to open stream: %s\n", irix_audio_get_last_error());
+        irix_audio_cleanup();
+        return 1;
+    }
+
+    irix_audio_rt_reset_report();
+    if (pthread_create(&thread, NULL, io_thread, &player) != 0) {
+        fprintf(stderr, "Failed to start I/O thread\n");
+        irix_audio_close_stream(player.stream);
+        irix_audio_cleanup();
+        return 1;
+    }
+    pthread_join(thread, NULL);
+
+    if (!player.enabled || player.failed) {
+        fprintf(stderr, "Playback failed: %s\n", irix_audio_get_last_error());
+        status = 1;
+    }
+
+    irix_audio_rt_get_report(&report);
+    printf("Played %d periods; guard saw %lu I/O calls\n", PERIODS, report.io_calls);
+
+#ifdef IRIX_AUDIO_RT_DEBUG
+    if (report.allocations == 1 && report.frees == 0 && report.locks == 0 &&
+        report.blocking_calls == 0 && report.first_violation &&
+        strcmp(report.first_violation, "malloc") == 0 &&
+        report.first_violation_io_call == MALLOC_PERIOD) {
+        printf("Caught the malloc on period %d: ok\n", MALLOC_PERIOD);
+    } else {
+        printf("Expected one malloc after %d I/O calls: FAIL\n", MALLOC_PERIOD);
+        status = 1;
+    }
+#else
+    printf("Built without IRIX_AUDIO_RT_DEBUG; the guard is compiled out\n");
+#endif
+
+    // Closing the guarded stream prints the report and releases the I/O
+    // thread's guard, though this is not the thread that enabled it
+    free(player.scratch);
+    irix_audio_close_stream(player.stream);
+    irix_audio_cleanup();
+    return status;
+}
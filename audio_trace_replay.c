@@ -0,0 +1,300 @@
+// Replays the call timing of an I/O trace against a stream of the same
+// shape, so a glitch recorded on one machine (or library version) can be
+// reproduced and compared on another, including the simulated device.
+//
+//   audio_trace_replay trace [replay_trace]   replay, then compare the two
+//   audio_trace_replay -s trace...            summarize traces side by side
+//   audio_trace_replay -r trace [seconds]     record a steady output workload
+
+#include "irix_audio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RECORD_RATE 44100
+#define RECORD_BUFFER 256
+#define RECORD_QUEUE 1024
+#define MAX_TRACES 8
+
+typedef struct {
+    const char* name;
+    int calls;
+    int writes;
+    int reads;
+    int renders;
+    int xruns;
+    int errors;
+    double span_ms;
+    double duration_mean_us;
+    double duration_max_us;
+    int fill_min;
+    double fill_mean;
+    int fill_max;
+    double render_mean_us;
+} TraceSummary;
+
+static long long now_ns(void) {
+    struct timespec ts;
+#ifdef __sgi
+    clock_gettime(CLOCK_SGI_CYCLE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleep_until(long long target) {
+    long long delta = target - now_ns();
+    if (delta > 0) {
+        struct timespec ts;
+        ts.tv_sec = delta / 1000000000LL;
+        ts.tv_nsec = delta % 1000000000LL;
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void summarize(const char* name, const IrixAudioTraceRecord* records, int count, TraceSummary* s) {
+    double duration_sum = 0.0, fill_sum = 0.0, render_sum = 0.0;
+    int io = 0, filled = 0;
+
+    memset(s, 0, sizeof(*s));
+    s->name = name;
+    s->calls = count;
+    for (int i = 0; i < count; i++) {
+        const IrixAudioTraceRecord* r = &records[i];
+        double us = r->duration_ns / 1000.0;
+        if (r->flags & IRIX_AUDIO_TRACE_XRUN) s->xruns++;
+        if (r->flags & IRIX_AUDIO_TRACE_ERROR) s->errors++;
+        // Callback time is the application's; keep it out of the I/O figures
+        if (r->op == IRIX_AUDIO_TRACE_RENDER) {
+            s->renders++;
+            render_sum += us;
+            continue;
+        }
+        if (r->op == IRIX_AUDIO_TRACE_READ) s->reads++;
+        else s->writes++;
+        duration_sum += us;
+        if (us > s->duration_max_us) s->duration_max_us = us;
+        io++;
+        // Calls the trace did not sample the fill for
+        if (r->fill < 0) continue;
+        fill_sum += r->fill;
+        if (filled == 0 || r->fill < s->fill_min) s->fill_min = r->fill;
+        if (filled == 0 || r->fill > s->fill_max) s->fill_max = r->fill;
+        filled++;
+    }
+    if (count > 0) s->span_ms = (records[count - 1].time_ns - records[0].time_ns) / 1e6;
+    if (io > 0) s->duration_mean_us = duration_sum / io;
+    if (filled > 0) s->fill_mean = fill_sum / filled;
+    if (s->renders > 0) s->render_mean_us = render_sum / s->renders;
+}
+
+static void print_summaries(const TraceSummary* s, int count) {
+    int i;
+
+    printf("  %-18s", "");
+    for (i = 0; i < count; i++) printf(" %14.14s", s[i].name);
+    printf("\n  %-18s", "calls");
+    for (i = 0; i < count; i++) printf(" %14d", s[i].calls);
+    printf("\n  %-18s", "writes / reads");
+    for (i = 0; i < count; i++) printf(" %8d/%-5d", s[i].writes, s[i].reads);
+    printf("\n  %-18s", "renders");
+    for (i = 0; i < count; i++) printf(" %14d", s[i].renders);
+    printf("\n  %-18s", "render mean (us)");
+    for (i = 0; i < count; i++) printf(" %14.1f", s[i].render_mean_us);
+    printf("\n  %-18s", "span (ms)");
+    for (i = 0; i < count; i++) printf(" %14.1f", s[i].span_ms);
+    printf("\n  %-18s", "xruns");
+    for (i = 0; i < count; i++) printf(" %14d", s[i].xruns);
+    printf("\n  %-18s", "errors");
+    for (i = 0; i < count; i++) printf(" %14d", s[i].errors);
+    printf("\n  %-18s", "call mean (us)");
+    for (i = 0; i < count; i++) printf(" %14.1f", s[i].duration_mean_us);
+    printf("\n  %-18s", "call max (us)");
+    for (i = 0; i < count; i++) printf(" %14.1f", s[i].duration_max_us);
+    printf("\n  %-18s", "fill min/mean/max");
+    for (i = 0; i < count; i++) printf(" %4d/%4.0f/%4d", s[i].fill_min, s[i].fill_mean, s[i].fill_max);
+    printf("\n");
+}
+
+// -s: summarize trace files side by side
+static int summarize_files(int count, char* paths[]) {
+    TraceSummary summaries[MAX_TRACES];
+    int n = 0;
+
+    for (int i = 0; i < count && n < MAX_TRACES; i++) {
+        IrixAudioTraceInfo info;
+        IrixAudioTraceRecord* records = irix_audio_trace_load(paths[i], &info);
+        if (!records) {
+            fprintf(stderr, "%s\n", irix_audio_get_last_error());
+            return 1;
+        }
+        printf("%s: %s, %d Hz, %d channels, queue %d, buffer %d, %d records (%lu lost)\n",
+               paths[i], info.mode == IRIX_AUDIO_OUTPUT ? "output" : "input", info.sample_rate,
+               info.channels, info.queue_size, info.buffer_size, info.records, info.records_lost);
+        summarize(paths[i], records, info.records, &summaries[n++]);
+        free(records);
+    }
+    print_summaries(summaries, n);
+    return 0;
+}
+
+// -r: write silence for a few seconds with tracing on
+static int record(const char* path, double seconds) {
+    IrixAudioStreamParams params = {
+        .mode = IRIX_AUDIO_OUTPUT,
+        .channels = 2,
+        .sample_rate = RECORD_RATE,
+        .buffer_size = RECORD_BUFFER,
+        .queue_size = RECORD_QUEUE
+    };
+    int periods = (int)(seconds * RECORD_RATE / RECORD_BUFFER);
+
+    IrixAudioStream* stream = irix_audio_open_stream(&params);
+    if (!stream) {
+        fprintf(stderr, "Failed to open stream: %s\n", irix_audio_get_last_error());
+        return 1;
+    }
+    IrixAudioTraceParams trace_params = { .records = periods + 1 };
+    IrixAudioTrace* trace = irix_audio_trace_open(stream, &trace_params);
+    float* buffer = calloc(RECORD_BUFFER * params.channels, sizeof(float));
+    if (!trace || !buffer) {
+        fprintf(stderr, "Failed to start trace: %s\n", irix_audio_get_last_error());
+        free(buffer);
+        irix_audio_trace_close(trace);
+        irix_audio_close_stream(stream);
+        return 1;
+    }
+
+    for (int i = 0; i < periods; i++) {
+        if (irix_audio_write_frames(stream, buffer, RECORD_BUFFER) < 0) break;
+    }
+
+    int status = irix_audio_trace_dump(trace, path);
+    if (status < 0) fprintf(stderr, "%s\n", irix_audio_get_last_error());
+    else printf("Recorded %d periods to %s\n", periods, path);
+
+    free(buffer);
+    irix_audio_trace_close(trace);
+    irix_audio_close_stream(stream);
+    return status < 0 ? 1 : 0;
+}
+
+// Issue each recorded call at its recorded time on a fresh stream
+static int replay(const char* path, const char* replay_path) {
+    IrixAudioTraceInfo info;
+    IrixAudioTraceRecord* records = irix_audio_trace_load(path, &info);
+    if (!records) {
+        fprintf(stderr, "%s\n", irix_audio_get_last_error());
+        return 1;
+    }
+    if (info.records == 0) {
+        fprintf(stderr, "%s: no records\n", path);
+        free(records);
+        return 1;
+    }
+
+    int max_frames = 0;
+    for (int i = 0; i < info.records; i++) {
+        if (records[i].frames_requested > max_frames) max_frames = records[i].frames_requested;
+    }
+
+    IrixAudioStreamParams params = {
+        .mode = info.mode,
+        .channels = info.channels,
+        .sample_rate = info.sample_rate,
+        .buffer_size = info.buffer_size,
+        .queue_size = info.queue_size
+    };
+    IrixAudioStream* stream = irix_audio_open_stream(&params);
+    if (!stream) {
+        fprintf(stderr, "Failed to open stream: %s\n", irix_audio_get_last_error());
+        free(records);
+        return 1;
+    }
+    IrixAudioTraceParams trace_params = { .records = info.records };
+    IrixAudioTrace* trace = irix_audio_trace_open(stream, &trace_params);
+    float* buffer = calloc((size_t)(max_frames > 0 ? max_frames : 1) * info.channels, sizeof(float));
+    if (!trace || !buffer) {
+        fprintf(stderr, "Failed to start trace: %s\n", irix_audio_get_last_error());
+        free(buffer);
+        irix_audio_trace_close(trace);
+        irix_audio_close_stream(stream);
+        free(records);
+        return 1;
+    }
+
+    printf("Replaying %d calls from %s\n", info.records, path);
+    long long start = now_ns();
+    for (int i = 0; i < info.records; i++) {
+        const IrixAudioTraceRecord* r = &records[i];
+        sleep_until(start + (r->time_ns - records[0].time_ns));
+        if (r->frames_requested <= 0) continue;
+        // Render records only time the application; the writes after them carry the pattern
+        if (r->op == IRIX_AUDIO_TRACE_WRITE || r->op == IRIX_AUDIO_TRACE_ZERO) {
+            irix_audio_write_frames(stream, buffer, r->frames_requested);
+        } else if (r->op == IRIX_AUDIO_TRACE_READ) {
+            irix_audio_read_frames(stream, buffer, r->frames_requested);
+        }
+    }
+
+    int status = irix_audio_trace_dump(trace, replay_path);
+    irix_audio_trace_close(trace);
+    irix_audio_close_stream(stream);
+    free(buffer);
+    if (status < 0) {
+        fprintf(stderr, "%s\n", irix_audio_get_last_error());
+        free(records);
+        return 1;
+    }
+
+    // Compare what was recorded with what the replay produced
+    IrixAudioTraceInfo replay_info;
+    IrixAudioTraceRecord* replayed = irix_audio_trace_load(replay_path, &replay_info);
+    if (!replayed) {
+        fprintf(stderr, "%s\n", irix_audio_get_last_error());
+        free(records);
+        return 1;
+    }
+    TraceSummary summaries[2];
+    summarize("recorded", records, info.records, &summaries[0]);
+    summarize("replayed", replayed, replay_info.records, &summaries[1]);
+    print_summaries(summaries, 2);
+    printf("Replay trace written to %s\n", replay_path);
+
+    free(replayed);
+    free(records);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int status;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s trace [replay_trace]\n", argv[0]);
+        fprintf(stderr, "       %s -s trace...\n", argv[0]);
+        fprintf(stderr, "       %s -r trace [seconds]\n", argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "-s") == 0) {
+        return summarize_files(argc - 2, argv + 2);
+    }
+
+    if (irix_audio_initialize() < 0) {
+        fprintf(stderr, "Failed to initialize audio: %s\n", irix_audio_get_last_error());
+        return 1;
+    }
+    if (strcmp(argv[1], "-r") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "Usage: %s -r trace [seconds]\n", argv[0]);
+            status = 1;
+        } else {
+            status = record(argv[2], argc > 3 ? atof(argv[3]) : 5.0);
+        }
+    } else {
+        status = replay(argv[1], argc > 2 ? argv[2] : "replay.trace");
+    }
+    irix_audio_cleanup();
+    return status;
+}
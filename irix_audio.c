@@ -3,9 +3,11 @@
 // Original Copyright (c) 2001-2005 Gary P. Scavone
 
 #include "irix_audio.h"
-#include <dmedia/audio.h>
+#include "irix_audio_internal.h"
 #include <unistd.h>
 #include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -16,6 +18,15 @@ const char* irix_audio_get_last_error() {
     return last_error_message;
 }
 
+// Set the last error message (shared with the other library modules)
+void irix_audio_set_error(const char* format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(last_error_message, sizeof(last_error_message), format, args);
+    va_end(args);
+}
+
 // Internal device structure 
 typedef struct {
     long output_resource;
@@ -223,6 +234,23 @@ IrixAudioStream* irix_audio_open_stream(IrixAudioStreamParams* params) {
         return NULL;
     }
 
+    // Every port buffer in the library is float in [-1, 1]; the AL default
+    // is 16-bit two's complement
+    if (alSetSampFmt(al_config, AL_SAMPFMT_FLOAT) < 0 || alSetFloatMax(al_config, 1.0) < 0) {
+        snprintf(last_error_message, sizeof(last_error_message), 
+                 "Cannot set float sample format: %s", alGetErrorString(oserror()));
+        alFreeConfig(al_config);
+        return NULL;
+    }
+
+    // Set the queue size, which bounds the latency the port can add
+    if (params->queue_size > 0 && alSetQueueSize(al_config, params->queue_size) < 0) {
+        snprintf(last_error_message, sizeof(last_error_message), 
+                 "Cannot set queue size %d: %s", params->queue_size, alGetErrorString(oserror()));
+        alFreeConfig(al_config);
+        return NULL;
+    }
+
     // Select resource based on mode
     resource = (params->mode == IRIX_AUDIO_OUTPUT) ? AL_DEFAULT_OUTPUT : AL_DEFAULT_INPUT;
 
@@ -237,7 +265,14 @@ IrixAudioStream* irix_audio_open_stream(IrixAudioStreamParams* params) {
     }
 
     // Allocate stream structure
-    IrixAudioStream* stream = malloc(sizeof(IrixAudioStream));
+    IrixAudioStream* stream = calloc(1, sizeof(IrixAudioStream));
+    if (!stream) {
+        snprintf(last_error_message, sizeof(last_error_message), 
+                 "Cannot allocate stream");
+        alClosePort(port);
+        alFreeConfig(al_config);
+        return NULL;
+    }
     stream->port = port;
     stream->mode = params->mode;
     stream->channels = params->channels;
@@ -262,47 +297,179 @@ IrixAudioStream* irix_audio_open_stream(IrixAudioStreamParams* params) {
     return stream;
 }
 
-// Write audio frames
-int irix_audio_write_frames(IrixAudioStream* stream, void* buffer, int frames) {
-    if (!stream || stream->mode != IRIX_AUDIO_OUTPUT) {
-        snprintf(last_error_message, sizeof(last_error_message), 
-                 "Invalid stream or mode");
-        return -1;
+// Write one block to the port through the attached chain
+static int stream_write_block(IrixAudioStream* stream, float* buffer, int frames) {
+    // Run the attached chain on a staged copy, leaving the caller's buffer intact
+    if (stream->chain) {
+        int written = 0;
+        while (written < frames) {
+            float* staged;
+            int n = irix_audio_chain_stage(stream->chain, buffer + written * stream->channels,
+                                           frames - written, &staged);
+            if (n < 0) return -1;
+            irix_audio_rt_io_begin();
+            int result = alWriteFrames(stream->port, staged, n);
+            irix_audio_rt_io_end();
+            if (result < 0) {
+                snprintf(last_error_message, sizeof(last_error_message), 
+                         "Error writing frames: %s", alGetErrorString(oserror()));
+                return -1;
+            }
+            written += n;
+        }
+        return written;
     }
 
+    // alWriteFrames blocks until every frame is queued
+    irix_audio_rt_io_begin();
     int written = alWriteFrames(stream->port, buffer, frames);
+    irix_audio_rt_io_end();
     if (written < 0) {
         snprintf(last_error_message, sizeof(last_error_message), 
                  "Error writing frames: %s", alGetErrorString(oserror()));
+        return -1;
     }
 
-    return written;
+    return frames;
 }
 
-// Read audio frames
-int irix_audio_read_frames(IrixAudioStream* stream, void* buffer, int frames) {
+// Read one block from the port and pass it down the attached consumers
+static int stream_read_block(IrixAudioStream* stream, float* buffer, int frames) {
+    // alReadFrames blocks until every frame has arrived
+    irix_audio_rt_io_begin();
+    int read = alReadFrames(stream->port, buffer, frames);
+    irix_audio_rt_io_end();
+    if (read < 0) {
+        snprintf(last_error_message, sizeof(last_error_message), 
+                 "Error reading frames: %s", alGetErrorString(oserror()));
+        return -1;
+    }
+    read = frames;
+    if (read > 0) {
+        if (stream->chain && irix_audio_chain_process(stream->chain, buffer, read) < 0) {
+            return -1;
+        }
+        // Forward captured frames to the attached network sink
+        if (stream->net) {
+            irix_audio_net_send(stream->net, buffer, read);
+        }
+        // Queue captured frames for the lossless encoder
+        if (stream->capture) {
+            irix_audio_capture_write(stream->capture, buffer, read);
+        }
+    }
+
+    return read;
+}
+
+// Write audio frames, split at the frames of attached events
+static int stream_write_frames(IrixAudioStream* stream, void* buffer, int frames) {
+    int done = 0;
+
+    if (!stream || stream->mode != IRIX_AUDIO_OUTPUT) {
+        snprintf(last_error_message, sizeof(last_error_message), 
+                 "Invalid stream or mode");
+        return -1;
+    }
+
+    while (done < frames) {
+        int n = frames - done;
+        if (stream->events) n = irix_audio_events_run(stream->events, stream, stream->position, n);
+        if (stream_write_block(stream, (float*)buffer + done * stream->channels, n) < 0) return -1;
+        stream->position += n;
+        done += n;
+    }
+
+    return frames;
+}
+
+// Read audio frames, split at the frames of attached events
+static int stream_read_frames(IrixAudioStream* stream, void* buffer, int frames) {
+    int done = 0;
+
     if (!stream || stream->mode != IRIX_AUDIO_INPUT) {
         snprintf(last_error_message, sizeof(last_error_message), 
                  "Invalid stream or mode");
         return -1;
     }
 
-    int read = alReadFrames(stream->port, buffer, frames);
-    if (read < 0) {
+    while (done < frames) {
+        int n = frames - done;
+        if (stream->events) n = irix_audio_events_run(stream->events, stream, stream->position, n);
+        if (stream_read_block(stream, (float*)buffer + done * stream->channels, n) < 0) return -1;
+        stream->position += n;
+        done += n;
+    }
+
+    return frames;
+}
+
+// Public entry points; the attached trace times each call around the AL transfer
+int irix_audio_write_frames(IrixAudioStream* stream, void* buffer, int frames) {
+    IrixAudioTraceMark mark;
+    int result;
+
+    if (!stream || !stream->trace) return stream_write_frames(stream, buffer, frames);
+    irix_audio_trace_begin(stream->trace, &mark, irix_audio_trace_fill(stream->trace));
+    result = stream_write_frames(stream, buffer, frames);
+    irix_audio_trace_end(stream->trace, &mark, IRIX_AUDIO_TRACE_WRITE, frames, result);
+    return result;
+}
+
+int irix_audio_read_frames(IrixAudioStream* stream, void* buffer, int frames) {
+    IrixAudioTraceMark mark;
+    int result;
+
+    if (!stream || !stream->trace) return stream_read_frames(stream, buffer, frames);
+    irix_audio_trace_begin(stream->trace, &mark, irix_audio_trace_fill(stream->trace));
+    result = stream_read_frames(stream, buffer, frames);
+    irix_audio_trace_end(stream->trace, &mark, IRIX_AUDIO_TRACE_READ, frames, result);
+    return result;
+}
+
+// Get the number of frames queued in the stream's port
+int irix_audio_get_filled(IrixAudioStream* stream) {
+    if (!stream || !stream->port) {
         snprintf(last_error_message, sizeof(last_error_message), 
-                 "Error reading frames: %s", alGetErrorString(oserror()));
+                 "Invalid stream");
+        return -1;
     }
 
-    return read;
+    int filled = alGetFilled(stream->port);
+    if (filled < 0) {
+        snprintf(last_error_message, sizeof(last_error_message), 
+                 "Error getting queue fill: %s", alGetErrorString(oserror()));
+    }
+
+    return filled;
+}
+
+// Frames written to or read from the stream since it was opened
+long long irix_audio_get_position(IrixAudioStream* stream) {
+    if (!stream) {
+        snprintf(last_error_message, sizeof(last_error_message), 
+                 "Invalid stream");
+        return -1;
+    }
+
+    return stream->position;
 }
 
 // Close an audio stream
 void irix_audio_close_stream(IrixAudioStream* stream) {
     if (!stream) return;
 
+    // The trace points back at the stream and may have a dumper running;
+    // the application still owns it and frees it with irix_audio_trace_close
+    if (stream->trace) irix_audio_trace_detach(stream->trace);
+    if (stream->rt_flags & IRIX_AUDIO_RT_GUARD) {
+        irix_audio_rt_print_report();
+        irix_audio_rt_disable(stream);
+    }
     if (stream->port) {
         alClosePort(stream->port);
     }
+    free(stream->rt_buffer);
     free(stream);
 }
 
@@ -5,7 +5,12 @@
 #ifndef IRIX_AUDIO_H
 #define IRIX_AUDIO_H
 
+#ifdef IRIX_AUDIO_SIMULATE
+#include "irix_audio_sim.h"
+#else
 #include <dmedia/audio.h>
+#endif
+#include <pthread.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,8 +50,33 @@ typedef struct {
     int channels;
     int sample_rate;
     int buffer_size;
+    int queue_size;             // Port queue in frames, 0 = AL default
 } IrixAudioStreamParams;
 
+// Network transport (opaque, see irix_audio_net.c)
+typedef struct IrixAudioNet IrixAudioNet;
+
+// Drift-compensated stream bridge (opaque, see irix_audio_bridge.c)
+typedef struct IrixAudioBridge IrixAudioBridge;
+
+// Processing chain (opaque, see irix_audio_dsp.c)
+typedef struct IrixAudioChain IrixAudioChain;
+
+// Partitioned convolver (opaque, see irix_audio_conv.c)
+typedef struct IrixAudioConvolver IrixAudioConvolver;
+
+// Lossless capture (opaque, see irix_audio_flac.c)
+typedef struct IrixAudioCapture IrixAudioCapture;
+
+// I/O timing trace (opaque, see irix_audio_trace.c)
+typedef struct IrixAudioTrace IrixAudioTrace;
+
+// Pull-model output with idle suspension (opaque, see irix_audio_render.c)
+typedef struct IrixAudioRender IrixAudioRender;
+
+// Timestamped event queue (opaque, see irix_audio_events.c)
+typedef struct IrixAudioEvents IrixAudioEvents;
+
 // Audio stream structure
 typedef struct {
     ALport port;
@@ -54,8 +84,275 @@ typedef struct {
     int channels;
     int sample_rate;
     int buffer_size;
+    IrixAudioNet* net;          // attached network source/sink, or NULL
+    IrixAudioChain* chain;      // attached processing chain, or NULL
+    IrixAudioCapture* capture;  // attached lossless capture sink, or NULL
+    IrixAudioTrace* trace;      // I/O timing trace, or NULL
+    IrixAudioEvents* events;    // attached event queue, or NULL
+    long long position;         // Stream timeline in frames, see irix_audio_get_position
+    void* rt_buffer;            // preallocated period buffer (real-time mode)
+    unsigned int rt_flags;      // IrixAudioRtFlags enabled on this stream
+    pthread_t rt_thread;        // Thread that called irix_audio_rt_enable
 } IrixAudioStream;
 
+// Network transport direction
+typedef enum {
+    IRIX_AUDIO_NET_SEND,
+    IRIX_AUDIO_NET_RECEIVE
+} IrixAudioNetDirection;
+
+// Network transport parameters
+typedef struct {
+    IrixAudioNetDirection direction;
+    const char* host;           // Remote host (SEND) or bind address (RECEIVE, NULL = any)
+    int port;                   // UDP port
+    int channels;
+    int sample_rate;
+    int packet_frames;          // Frames carried by each packet
+    int max_latency_frames;     // Jitter buffer capacity (RECEIVE)
+    double loss_rate;           // Simulated packet loss, 0.0 - 1.0 (RECEIVE)
+    int jitter_frames;          // Simulated arrival jitter, 0 = off (RECEIVE)
+} IrixAudioNetParams;
+
+// Network receiver statistics
+typedef struct {
+    unsigned long packets_sent;
+    unsigned long packets_received;
+    unsigned long packets_lost;         // Never arrived before their playout time
+    unsigned long packets_late;         // Arrived after their playout time
+    unsigned long packets_skipped;      // Merged into the previous packet to shrink latency
+    unsigned long packets_inserted;     // Crossfaded packets inserted to grow latency
+    unsigned long frames_concealed;     // Frames produced by loss concealment
+    unsigned long underruns;            // Jitter buffer ran empty
+    double jitter_frames;               // Interarrival jitter estimate
+    int target_latency_frames;
+    int current_latency_frames;
+} IrixAudioNetStats;
+
+// Bridge parameters
+typedef struct {
+    int target_latency_frames;  // Output fill plus unread input to hold (default 2 periods)
+    int period_frames;          // Frames read per cycle (default input buffer_size)
+    double bandwidth_hz;        // Drift tracking loop bandwidth (default 0.05)
+} IrixAudioBridgeParams;
+
+// Bridge statistics
+typedef struct {
+    double ratio;               // Output frames produced per input frame
+    double drift_ppm;           // Estimated clock drift, output relative to input
+    double latency_frames;      // Smoothed output queue fill plus unread input
+    double latency_min_frames;  // Since open or the last stats reset
+    double latency_max_frames;
+    double latency_error_rms;   // RMS deviation from the target
+    unsigned long frames_in;
+    unsigned long frames_out;
+    unsigned long underflows;   // Output queue found empty
+} IrixAudioBridgeStats;
+
+// EQ band shapes
+typedef enum {
+    IRIX_AUDIO_EQ_OFF,
+    IRIX_AUDIO_EQ_PEAK,
+    IRIX_AUDIO_EQ_LOW_SHELF,
+    IRIX_AUDIO_EQ_HIGH_SHELF,
+    IRIX_AUDIO_EQ_LOW_PASS,
+    IRIX_AUDIO_EQ_HIGH_PASS
+} IrixAudioEqShape;
+
+// Convolver parameters
+typedef struct {
+    int block_frames;           // Head partition size: the stream period (power of two)
+    int tail_block_frames;      // Tail partition size (power of two), 0 = uniform
+    int background;             // Compute the tail on a worker thread
+} IrixAudioConvolverParams;
+
+// Convolver statistics
+typedef struct {
+    int head_partitions;
+    int tail_partitions;
+    unsigned long blocks;
+    unsigned long tail_jobs;
+    unsigned long tail_waits;   // Audio thread had to wait for the worker
+} IrixAudioConvolverStats;
+
+// Lossless capture parameters
+typedef struct {
+    const char* path;           // Output FLAC file
+    int channels;               // 1 - 8
+    int sample_rate;
+    int bits_per_sample;        // 16 or 24 (default 24)
+    int block_frames;           // Frames per encoded block (default 4096)
+    int queue_blocks;           // Blocks buffered for the encoders (default 32)
+    int workers;                // Encoder threads (default 2)
+} IrixAudioCaptureParams;
+
+// Lossless capture statistics
+typedef struct {
+    unsigned long long frames_captured; // Accepted into the queue
+    unsigned long long frames_dropped;  // Queue was full
+    unsigned long blocks_encoded;       // Written to the file
+    unsigned long long bytes_written;
+    unsigned long write_errors;
+    double compression_ratio;           // PCM size / encoded size of written frames
+} IrixAudioCaptureStats;
+
+// Latency measurement parameters
+typedef struct {
+    int period_frames;          // Frames per write and read (default output buffer_size)
+    int signal_frames;          // Test sweep length (default 16384)
+    int max_latency_frames;     // Longest round trip searched (default 1 second)
+    int settle_frames;          // Loop run before measuring (default 1/4 second)
+    int input_channel;          // Input channel compared with the sweep
+    int attempts;               // Captures tried while xruns disturb them (default 3)
+    int xrun_frames;            // Queue fill movement taken as an xrun (default 1)
+    double level;               // Sweep amplitude (default 0.5)
+} IrixAudioLatencyParams;
+
+// Latency measurement result, in frames
+typedef struct {
+    double round_trip_frames;   // From writing a frame to reading it back
+    double output_frames;       // Mean output queue ahead of each write
+    double input_frames;        // Mean input queue behind each read
+    double external_frames;     // Remainder outside the queues (converters, path)
+    double snr_db;              // Correlation peak over the remaining lags
+    int restarts;               // Captures discarded because of xruns
+    int sample_rate;
+} IrixAudioLatencyResult;
+
+// Trace record operations and flags
+typedef enum {
+    IRIX_AUDIO_TRACE_WRITE = 1,
+    IRIX_AUDIO_TRACE_READ = 2,
+    IRIX_AUDIO_TRACE_RENDER = 3,    // Render callback; frames_transferred is its result
+    IRIX_AUDIO_TRACE_ZERO = 4       // Silence queued by an idle render engine
+} IrixAudioTraceOp;
+
+#define IRIX_AUDIO_TRACE_XRUN 0x1       // Output queue empty / input queue full at entry
+#define IRIX_AUDIO_TRACE_ERROR 0x2      // The call failed
+
+// One traced I/O call
+typedef struct {
+    long long time_ns;          // Call entry, relative to the start of the trace
+    int duration_ns;            // Time spent in the call
+    int frames_requested;
+    int frames_transferred;     // Return value of the call
+    int fill;                   // Port queue fill at entry, -1 if not sampled
+    int op;                     // IrixAudioTraceOp
+    int flags;
+} IrixAudioTraceRecord;
+
+// Trace parameters
+typedef struct {
+    int records;                // Ring capacity (default 4096)
+    const char* xrun_path;      // Dump to xrun_path.N after each xrun, NULL = on demand only
+    int post_xrun_records;      // Calls recorded after an xrun before dumping (default 64)
+    int fill_interval;          // Calls per queue fill sample (default 1), < 0 = never
+} IrixAudioTraceParams;
+
+// Trace statistics
+typedef struct {
+    unsigned long records;          // Records written
+    unsigned long records_skipped;  // Calls not recorded while a dump was in progress
+    unsigned long xruns;
+    unsigned long dumps;            // Trace files written
+} IrixAudioTraceStats;
+
+// Trace file description
+typedef struct {
+    IrixAudioMode mode;
+    int sample_rate;
+    int channels;
+    int queue_size;
+    int buffer_size;
+    int records;
+    unsigned long records_lost;     // Overwritten in the ring before the dump
+} IrixAudioTraceInfo;
+
+// Render callback: fill buffer with up to frames interleaved frames.
+// Returns the frames rendered (the rest of the period is silence), or -1
+// to stop the engine.
+typedef int (*IrixAudioRenderCallback)(void* user, float* buffer, int frames);
+
+// What an idle render engine does with the port
+typedef enum {
+    IRIX_AUDIO_IDLE_ZERO,       // Keep idle_fill_frames of silence queued (alZeroFrames)
+    IRIX_AUDIO_IDLE_DRAIN       // Let the queue run empty
+} IrixAudioIdleMode;
+
+// Render parameters
+typedef struct {
+    int period_frames;          // Frames per callback (default stream buffer_size)
+    double silence_db;          // Peak level counted as silence (default -90 dBFS)
+    int idle_periods;           // Silent periods before idling (default 1/2 second), < 0 = never
+    IrixAudioIdleMode idle_mode;
+    int idle_fill_frames;       // Silence kept queued while idle (default two periods)
+} IrixAudioRenderParams;
+
+// Render statistics
+typedef struct {
+    unsigned long periods_rendered;     // Periods rendered by the callback
+    unsigned long periods_silent;       // Rendered periods below the threshold
+    unsigned long periods_idle;         // Periods passed without calling back
+    unsigned long idle_entries;
+    unsigned long wakes;
+    int idle;                           // Currently idle
+} IrixAudioRenderStats;
+
+// Event types
+typedef enum {
+    IRIX_AUDIO_EVENT_GAIN,      // Ramp chain gain stage node to gain_db from this frame
+    IRIX_AUDIO_EVENT_CALLBACK,  // Call callback(user, event) on the audio thread
+    IRIX_AUDIO_EVENT_MARKER     // Hand the event back through irix_audio_events_poll
+} IrixAudioEventType;
+
+typedef struct IrixAudioEvent IrixAudioEvent;
+typedef void (*IrixAudioEventCallback)(void* user, const IrixAudioEvent* event);
+
+// An event due at an absolute stream frame
+struct IrixAudioEvent {
+    long long frame;            // Stream position the event lands on
+    IrixAudioEventType type;
+    int node;                   // GAIN: chain stage index
+    double gain_db;             // GAIN: new level
+    int id;                     // Application tag
+    IrixAudioEventCallback callback;    // CALLBACK
+    void* user;                         // CALLBACK
+};
+
+// Event queue statistics
+typedef struct {
+    unsigned long posted;
+    unsigned long applied;
+    unsigned long late;         // Applied after their frame had passed
+    unsigned long dropped;      // Gain events without a matching chain stage
+    unsigned long markers_lost; // Markers not polled before the return queue filled
+    int pending;                // Posted and not yet applied
+} IrixAudioEventStats;
+
+// Real-time mode flags
+typedef enum {
+    IRIX_AUDIO_RT_LOCK_MEMORY = 0x1,    // Lock all process memory (plock/mlockall)
+    IRIX_AUDIO_RT_PRIORITY = 0x2,       // SCHED_FIFO priority for the I/O thread
+    IRIX_AUDIO_RT_GUARD = 0x4           // Report unsafe calls (IRIX_AUDIO_RT_DEBUG builds)
+} IrixAudioRtFlags;
+
+// Real-time mode parameters
+typedef struct {
+    unsigned int flags;
+    int priority;               // SCHED_FIFO priority, 0 = middle of the range
+} IrixAudioRtParams;
+
+// Real-time guard report
+typedef struct {
+    unsigned long allocations;          // malloc/calloc/realloc
+    unsigned long frees;
+    unsigned long locks;                // Mutex lock, condition or semaphore wait
+    unsigned long blocking_calls;       // read/write/sleep outside audio I/O
+    unsigned long io_calls;             // Audio I/O calls on guarded threads
+    const char* first_violation;        // Name of the first offending call, or NULL
+    unsigned long first_violation_io_call;  // io_calls when it happened
+} IrixAudioRtReport;
+
 // Function prototypes
 const char* irix_audio_get_last_error();
 
@@ -72,6 +369,106 @@ void irix_audio_close_stream(IrixAudioStream* stream);
 // Audio I/O
 int irix_audio_write_frames(IrixAudioStream* stream, void* buffer, int frames);
 int irix_audio_read_frames(IrixAudioStream* stream, void* buffer, int frames);
+int irix_audio_get_filled(IrixAudioStream* stream);
+// The position counts frames written or read since open, plus the periods
+// a render engine in IRIX_AUDIO_IDLE_DRAIN mode passes without writing;
+// it is the timeline events are keyed to, not a count of frames queued
+long long irix_audio_get_position(IrixAudioStream* stream);
+
+// I/O timing trace (closing the stream detaches its trace)
+IrixAudioTrace* irix_audio_trace_open(IrixAudioStream* stream, IrixAudioTraceParams* params);
+void irix_audio_trace_close(IrixAudioTrace* trace);
+int irix_audio_trace_dump(IrixAudioTrace* trace, const char* path);
+int irix_audio_trace_get_stats(IrixAudioTrace* trace, IrixAudioTraceStats* stats);
+IrixAudioTraceRecord* irix_audio_trace_load(const char* path, IrixAudioTraceInfo* info);
+
+// Pull-model output (32-bit float samples)
+// irix_audio_render_process runs one period; irix_audio_render_wake may be
+// called from any thread and resumes an idle engine within one period
+IrixAudioRender* irix_audio_render_open(IrixAudioStream* stream, IrixAudioRenderCallback callback,
+                                        void* user, IrixAudioRenderParams* params);
+void irix_audio_render_close(IrixAudioRender* render);
+int irix_audio_render_process(IrixAudioRender* render);
+void irix_audio_render_wake(IrixAudioRender* render);
+int irix_audio_render_get_stats(IrixAudioRender* render, IrixAudioRenderStats* stats);
+
+// Timestamped events, applied at their exact frame inside the write, read
+// and render paths. Post from one control thread; the audio thread never
+// locks or allocates.
+IrixAudioEvents* irix_audio_events_create(int capacity);
+void irix_audio_events_destroy(IrixAudioEvents* events);
+int irix_audio_events_attach(IrixAudioStream* stream, IrixAudioEvents* events);
+int irix_audio_events_post(IrixAudioEvents* events, const IrixAudioEvent* event);
+int irix_audio_events_poll(IrixAudioEvents* events, IrixAudioEvent* marker);
+int irix_audio_events_get_stats(IrixAudioEvents* events, IrixAudioEventStats* stats);
+
+// Latency measurement (32-bit float samples)
+int irix_audio_measure_latency(IrixAudioStream* output, IrixAudioStream* input,
+                               IrixAudioLatencyParams* params, IrixAudioLatencyResult* result);
+
+// Real-time mode
+int irix_audio_rt_enable(IrixAudioStream* stream, IrixAudioRtParams* params);
+void* irix_audio_rt_buffer(IrixAudioStream* stream);
+void irix_audio_rt_disable(IrixAudioStream* stream);
+void irix_audio_rt_release_thread(void);
+int irix_audio_rt_get_report(IrixAudioRtReport* report);
+void irix_audio_rt_reset_report(void);
+void irix_audio_rt_print_report(void);
+
+// Network transport (32-bit float samples)
+IrixAudioNet* irix_audio_net_open(IrixAudioNetParams* params);
+void irix_audio_net_close(IrixAudioNet* net);
+int irix_audio_net_send(IrixAudioNet* net, const float* buffer, int frames);
+int irix_audio_net_receive(IrixAudioNet* net, float* buffer, int frames);
+int irix_audio_net_get_stats(IrixAudioNet* net, IrixAudioNetStats* stats);
+int irix_audio_net_attach(IrixAudioStream* stream, IrixAudioNet* net);
+int irix_audio_net_pump(IrixAudioStream* stream, int frames);
+
+// Drift-compensated bridge (32-bit float samples)
+IrixAudioBridge* irix_audio_bridge_open(IrixAudioStream* input, IrixAudioStream* output,
+                                        IrixAudioBridgeParams* params);
+void irix_audio_bridge_close(IrixAudioBridge* bridge);
+int irix_audio_bridge_process(IrixAudioBridge* bridge);
+int irix_audio_bridge_get_stats(IrixAudioBridge* bridge, IrixAudioBridgeStats* stats);
+void irix_audio_bridge_reset_stats(IrixAudioBridge* bridge);
+
+// Processing chain (32-bit float samples)
+// Build the chain before attaching it; the set functions may then be
+// called from one control thread while the audio thread processes.
+IrixAudioChain* irix_audio_chain_create(int channels, int sample_rate, int max_frames);
+void irix_audio_chain_destroy(IrixAudioChain* chain);
+int irix_audio_chain_add_gain(IrixAudioChain* chain, double gain_db, double ramp_ms);
+int irix_audio_chain_add_eq(IrixAudioChain* chain, int bands);
+int irix_audio_chain_add_dynamics(IrixAudioChain* chain, double threshold_db, double ratio,
+                                  double attack_ms, double release_ms, double makeup_db);
+int irix_audio_chain_add_matrix(IrixAudioChain* chain);
+int irix_audio_chain_set_gain(IrixAudioChain* chain, int node, double gain_db);
+int irix_audio_chain_set_eq_band(IrixAudioChain* chain, int node, int band, IrixAudioEqShape shape,
+                                 double freq_hz, double q, double gain_db);
+int irix_audio_chain_set_dynamics(IrixAudioChain* chain, int node, double threshold_db, double ratio,
+                                  double attack_ms, double release_ms, double makeup_db);
+int irix_audio_chain_set_matrix(IrixAudioChain* chain, int node, int out_channel, int in_channel,
+                                double gain);
+int irix_audio_chain_process(IrixAudioChain* chain, float* buffer, int frames);
+int irix_audio_chain_attach(IrixAudioStream* stream, IrixAudioChain* chain);
+
+// Partitioned FFT convolution (32-bit float samples)
+IrixAudioConvolver* irix_audio_convolver_create(int channels, const float* ir, int ir_frames,
+                                                int ir_channels, IrixAudioConvolverParams* params);
+void irix_audio_convolver_destroy(IrixAudioConvolver* conv);
+int irix_audio_convolver_process(IrixAudioConvolver* conv, float* buffer, int frames);
+int irix_audio_convolver_get_stats(IrixAudioConvolver* conv, IrixAudioConvolverStats* stats);
+int irix_audio_chain_add_convolver(IrixAudioChain* chain, IrixAudioConvolver* conv);
+
+// Lossless capture (32-bit float samples in, FLAC out)
+// irix_audio_capture_write never blocks: blocks that find the queue full
+// are dropped and counted.
+IrixAudioCapture* irix_audio_capture_open(IrixAudioCaptureParams* params);
+int irix_audio_capture_write(IrixAudioCapture* cap, const float* buffer, int frames);
+int irix_audio_capture_finish(IrixAudioCapture* cap);
+int irix_audio_capture_close(IrixAudioCapture* cap);
+int irix_audio_capture_get_stats(IrixAudioCapture* cap, IrixAudioCaptureStats* stats);
+int irix_audio_capture_attach(IrixAudioStream* stream, IrixAudioCapture* cap);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,265 @@
+// IRIX Audio Library - Drift-compensated stream bridge
+// Moves audio from an input stream to an output stream running on a
+// different clock, holding the output queue at a target fill level
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BRIDGE_HISTORY 3            // Input frames kept for the cubic interpolator
+#define BRIDGE_MAX_DRIFT 0.005      // Largest correction applied (5000 ppm)
+#define BRIDGE_DAMPING 0.707        // Loop damping factor
+#define BRIDGE_SMOOTHING 0.01       // Latency smoothing per period (statistics only)
+
+struct IrixAudioBridge {
+    IrixAudioStream* input;
+    IrixAudioStream* output;
+    IrixAudioBridgeParams params;
+    int channels;
+    double nominal;             // Nominal output/input rate ratio
+
+    // Tracking loop
+    double kp;
+    double ki;
+    double drift;               // Integrator: estimated relative clock drift
+    double ratio;
+
+    // Resampler
+    float* work;                // History followed by the current input period
+    float* out;
+    int out_capacity;
+    double position;            // Read position in work, in input frames
+
+    // Statistics
+    IrixAudioBridgeStats stats;
+    double error_sum;
+    unsigned long error_count;
+    int have_latency;
+};
+
+// Queue frames of silence on the output
+static int bridge_prime(IrixAudioBridge* bridge, int missing) {
+    memset(bridge->out, 0, bridge->out_capacity * bridge->channels * sizeof(float));
+    while (missing > 0) {
+        int n = (missing < bridge->out_capacity) ? missing : bridge->out_capacity;
+        if (irix_audio_write_frames(bridge->output, bridge->out, n) < 0) return -1;
+        missing -= n;
+    }
+    return 0;
+}
+
+// Read and drop frames of input
+static int bridge_discard(IrixAudioBridge* bridge, int frames) {
+    while (frames > 0) {
+        int n = (frames < bridge->out_capacity) ? frames : bridge->out_capacity;
+        if (irix_audio_read_frames(bridge->input, bridge->out, n) < 0) return -1;
+        frames -= n;
+    }
+    return 0;
+}
+
+// Open a bridge between an input and an output stream
+IrixAudioBridge* irix_audio_bridge_open(IrixAudioStream* input, IrixAudioStream* output,
+                                        IrixAudioBridgeParams* params) {
+    IrixAudioBridge* bridge;
+    double omega, gain;
+
+    if (!input || !output || input->mode != IRIX_AUDIO_INPUT ||
+        output->mode != IRIX_AUDIO_OUTPUT || input->channels != output->channels) {
+        irix_audio_set_error("Bridge requires an input and an output stream with equal channels");
+        return NULL;
+    }
+
+    bridge = calloc(1, sizeof(IrixAudioBridge));
+    if (!bridge) {
+        irix_audio_set_error("Cannot allocate bridge");
+        return NULL;
+    }
+    bridge->input = input;
+    bridge->output = output;
+    bridge->channels = input->channels;
+    if (params) bridge->params = *params;
+    if (bridge->params.period_frames <= 0) bridge->params.period_frames = input->buffer_size;
+    if (bridge->params.period_frames <= 0) bridge->params.period_frames = 256;
+    if (bridge->params.target_latency_frames <= 0)
+        bridge->params.target_latency_frames = 2 * bridge->params.period_frames;
+    if (bridge->params.bandwidth_hz <= 0.0) bridge->params.bandwidth_hz = 0.05;
+
+    bridge->nominal = (double)output->sample_rate / (double)input->sample_rate;
+    bridge->ratio = bridge->nominal;
+
+    // PI loop on the queue fill: an integrator plant with gain period * nominal
+    omega = 2.0 * M_PI * bridge->params.bandwidth_hz * bridge->params.period_frames /
+            input->sample_rate;
+    gain = bridge->params.period_frames * bridge->nominal;
+    bridge->kp = 2.0 * BRIDGE_DAMPING * omega / gain;
+    bridge->ki = omega * omega / gain;
+
+    bridge->out_capacity = (int)(bridge->params.period_frames * bridge->nominal *
+                                 (1.0 + BRIDGE_MAX_DRIFT)) + 4;
+    bridge->work = calloc((bridge->params.period_frames + BRIDGE_HISTORY) * bridge->channels,
+                          sizeof(float));
+    bridge->out = malloc(bridge->out_capacity * bridge->channels * sizeof(float));
+    if (!bridge->work || !bridge->out) {
+        irix_audio_set_error("Cannot allocate bridge buffers");
+        irix_audio_bridge_close(bridge);
+        return NULL;
+    }
+    bridge->position = 1.0;
+    irix_audio_bridge_reset_stats(bridge);
+
+    // Start with the target latency queued on the output, plus the period
+    // the first read lets drain before the fill is sampled
+    if (bridge_prime(bridge, bridge->params.target_latency_frames + bridge->params.period_frames) < 0) {
+        irix_audio_bridge_close(bridge);
+        return NULL;
+    }
+
+    return bridge;
+}
+
+// Close a bridge (the streams stay open)
+void irix_audio_bridge_close(IrixAudioBridge* bridge) {
+    if (!bridge) return;
+
+    free(bridge->work);
+    free(bridge->out);
+    free(bridge);
+}
+
+// Update the drift estimate from the output queue fill
+static void bridge_track(IrixAudioBridge* bridge, int filled) {
+    double error = filled - bridge->params.target_latency_frames;
+    double correction;
+
+    bridge->drift -= bridge->ki * error;
+    if (bridge->drift > BRIDGE_MAX_DRIFT) bridge->drift = BRIDGE_MAX_DRIFT;
+    if (bridge->drift < -BRIDGE_MAX_DRIFT) bridge->drift = -BRIDGE_MAX_DRIFT;
+
+    correction = bridge->drift - bridge->kp * error;
+    if (correction > BRIDGE_MAX_DRIFT) correction = BRIDGE_MAX_DRIFT;
+    if (correction < -BRIDGE_MAX_DRIFT) correction = -BRIDGE_MAX_DRIFT;
+    bridge->ratio = bridge->nominal * (1.0 + correction);
+
+    // Statistics
+    if (!bridge->have_latency) {
+        bridge->stats.latency_frames = filled;
+        bridge->have_latency = 1;
+    }
+    bridge->stats.latency_frames += (filled - bridge->stats.latency_frames) * BRIDGE_SMOOTHING;
+    if (filled < bridge->stats.latency_min_frames) bridge->stats.latency_min_frames = filled;
+    if (filled > bridge->stats.latency_max_frames) bridge->stats.latency_max_frames = filled;
+    bridge->error_sum += error * error;
+    bridge->error_count++;
+}
+
+// Resample the current period into out; returns output frame count
+static int bridge_resample(IrixAudioBridge* bridge) {
+    int period = bridge->params.period_frames;
+    int channels = bridge->channels;
+    double step = 1.0 / bridge->ratio;
+    double limit = period + 1.0;
+    const float* work = bridge->work;
+    float* out = bridge->out;
+    int produced = 0;
+    int c;
+
+    // 4-point cubic Hermite between work[i] and work[i + 1]
+    while (bridge->position < limit && produced < bridge->out_capacity) {
+        int i = (int)bridge->position;
+        float t = (float)(bridge->position - i);
+        const float* x0 = work + (i - 1) * channels;
+        const float* x1 = x0 + channels;
+        const float* x2 = x1 + channels;
+        const float* x3 = x2 + channels;
+
+        for (c = 0; c < channels; c++) {
+            float c1 = 0.5f * (x2[c] - x0[c]);
+            float c2 = x0[c] - 2.5f * x1[c] + 2.0f * x2[c] - 0.5f * x3[c];
+            float c3 = 0.5f * (x3[c] - x0[c]) + 1.5f * (x1[c] - x2[c]);
+            out[c] = ((c3 * t + c2) * t + c1) * t + x1[c];
+        }
+        out += channels;
+        produced++;
+        bridge->position += step;
+    }
+
+    // Keep the tail as history for the next period
+    bridge->position -= period;
+    memmove(bridge->work, bridge->work + period * channels,
+            BRIDGE_HISTORY * channels * sizeof(float));
+
+    return produced;
+}
+
+// Move one period from input to output; returns input frames consumed
+int irix_audio_bridge_process(IrixAudioBridge* bridge) {
+    int period, filled, backlog, read, produced;
+
+    if (!bridge) {
+        irix_audio_set_error("Invalid bridge");
+        return -1;
+    }
+    period = bridge->params.period_frames;
+
+    // The input clock paces the bridge
+    read = irix_audio_read_frames(bridge->input,
+                                  bridge->work + BRIDGE_HISTORY * bridge->channels, period);
+    if (read < 0) return -1;
+    if (read < period) {
+        memset(bridge->work + (BRIDGE_HISTORY + read) * bridge->channels, 0,
+               (period - read) * bridge->channels * sizeof(float));
+    }
+
+    // Measure the output queue at the same phase every period. Input still
+    // waiting to be read counts too: when the bridge is held up, frames
+    // move from the output queue to the input queue, which is not drift.
+    filled = irix_audio_get_filled(bridge->output);
+    backlog = irix_audio_get_filled(bridge->input);
+    if (filled < 0 || backlog < 0) return -1;
+    if (filled == 0) {
+        // The output ran dry while input kept arriving; restart at the target
+        bridge->stats.underflows++;
+        if (backlog > bridge->params.target_latency_frames) {
+            if (bridge_discard(bridge, backlog - bridge->params.target_latency_frames) < 0) return -1;
+            backlog = bridge->params.target_latency_frames;
+        }
+        if (bridge_prime(bridge, bridge->params.target_latency_frames - backlog) < 0) return -1;
+        filled = bridge->params.target_latency_frames - backlog;
+    }
+    bridge_track(bridge, filled + backlog);
+
+    produced = bridge_resample(bridge);
+    if (irix_audio_write_frames(bridge->output, bridge->out, produced) < 0) return -1;
+
+    bridge->stats.frames_in += read;
+    bridge->stats.frames_out += produced;
+    return read;
+}
+
+// Get bridge statistics
+int irix_audio_bridge_get_stats(IrixAudioBridge* bridge, IrixAudioBridgeStats* stats) {
+    if (!bridge || !stats) {
+        irix_audio_set_error("Invalid bridge");
+        return -1;
+    }
+
+    *stats = bridge->stats;
+    stats->ratio = bridge->ratio;
+    stats->drift_ppm = bridge->drift * 1e6;
+    stats->latency_error_rms = bridge->error_count ?
+                               sqrt(bridge->error_sum / bridge->error_count) : 0.0;
+    return 0;
+}
+
+// Restart the latency window (min/max/RMS) of the statistics
+void irix_audio_bridge_reset_stats(IrixAudioBridge* bridge) {
+    if (!bridge) return;
+
+    bridge->stats.latency_min_frames = 1e30;
+    bridge->stats.latency_max_frames = 0.0;
+    bridge->error_sum = 0.0;
+    bridge->error_count = 0;
+}
@@ -0,0 +1,447 @@
+// IRIX Audio Library - Partitioned FFT convolution
+// Uniformly partitioned overlap-save convolution at the stream period,
+// optionally split in two: the head of the impulse response runs on the
+// audio thread with period-sized partitions, the tail runs with larger
+// partitions that can be computed on a background thread. A block FIFO
+// in front lets callers pass any number of frames, at one block of latency.
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One uniformly partitioned segment of the impulse response
+typedef struct {
+    int block;
+    int partitions;
+    int bins;                   // block + 1
+    int channels;
+    IrixAudioFft* fft;          // Size 2 * block
+    float* ir_re;               // [ir_set][partition][bins]
+    float* ir_im;
+    float* input;               // [channel][2 * block] overlap-save input
+    float* fdl_re;              // [channel][partition][bins] frequency delay line
+    float* fdl_im;
+    int fdl_pos;
+    float* time;                // Scratch, 2 * block
+    float* acc_re;              // Scratch, bins
+    float* acc_im;
+} ConvSegment;
+
+struct IrixAudioConvolver {
+    int channels;
+    int ir_channels;
+    int block;
+    int tail_block;
+    int has_tail;
+    int background;
+    long position;              // Frames processed
+
+    ConvSegment head;
+    ConvSegment tail;
+    float* channel_in;          // Scratch, block
+    float* channel_out;
+
+    // Block FIFO: frames collect in fifo_in while the previous block's
+    // output drains from fifo_out; the two swap once a block is full
+    float* fifo_in;             // [block][channels] interleaved
+    float* fifo_out;
+    int fifo_fill;
+
+    // Tail pipeline: job j consumes input [jL, (j+1)L) and produces
+    // the tail output for [(j+2)L, (j+3)L)
+    float* tail_in[2];          // [channel][tail_block], double-buffered
+    int tail_fill;
+    unsigned long tail_submitted;
+    float* tail_out;            // [channel][2 * tail_block] ring
+    float* tail_channel_out;    // Scratch, tail_block
+
+    // Background worker
+    pthread_t worker;
+    int worker_running;
+    sem_t job_ready;
+    sem_t job_done;
+    volatile int quit;
+    unsigned long worker_jobs;
+
+    IrixAudioConvolverStats stats;
+};
+
+static void conv_segment_free(ConvSegment* seg) {
+    irix_audio_fft_destroy(seg->fft);
+    free(seg->ir_re);
+    free(seg->ir_im);
+    free(seg->input);
+    free(seg->fdl_re);
+    free(seg->fdl_im);
+    free(seg->time);
+    free(seg->acc_re);
+    free(seg->acc_im);
+    memset(seg, 0, sizeof(ConvSegment));
+}
+
+// Transform ir[offset, offset + length) into block-sized partitions
+static int conv_segment_init(ConvSegment* seg, int block, int channels, const float* ir,
+                             int ir_frames, int ir_channels, int offset, int length) {
+    int set, p, i;
+
+    memset(seg, 0, sizeof(ConvSegment));
+    seg->block = block;
+    seg->bins = block + 1;
+    seg->channels = channels;
+    seg->partitions = (length + block - 1) / block;
+
+    seg->fft = irix_audio_fft_create(2 * block);
+    if (!seg->fft) return -1;
+
+    seg->ir_re = calloc(ir_channels * seg->partitions * seg->bins, sizeof(float));
+    seg->ir_im = calloc(ir_channels * seg->partitions * seg->bins, sizeof(float));
+    seg->input = calloc(channels * 2 * block, sizeof(float));
+    seg->fdl_re = calloc(channels * seg->partitions * seg->bins, sizeof(float));
+    seg->fdl_im = calloc(channels * seg->partitions * seg->bins, sizeof(float));
+    seg->time = calloc(2 * block, sizeof(float));
+    seg->acc_re = malloc(seg->bins * sizeof(float));
+    seg->acc_im = malloc(seg->bins * sizeof(float));
+    if (!seg->ir_re || !seg->ir_im || !seg->input || !seg->fdl_re || !seg->fdl_im ||
+        !seg->time || !seg->acc_re || !seg->acc_im) {
+        irix_audio_set_error("Cannot allocate convolution partitions");
+        conv_segment_free(seg);
+        return -1;
+    }
+
+    for (set = 0; set < ir_channels; set++) {
+        for (p = 0; p < seg->partitions; p++) {
+            int index = (set * seg->partitions + p) * seg->bins;
+
+            // Partition zero-padded to twice its length
+            memset(seg->time, 0, 2 * block * sizeof(float));
+            for (i = 0; i < block; i++) {
+                int frame = offset + p * block + i;
+                if (frame >= offset + length || frame >= ir_frames) break;
+                seg->time[i] = ir[frame * ir_channels + set];
+            }
+            irix_audio_fft_forward(seg->fft, seg->time, seg->ir_re + index, seg->ir_im + index);
+        }
+    }
+    return 0;
+}
+
+// Convolve one block of one channel; out receives block frames
+static void conv_segment_process(ConvSegment* seg, int channel, int ir_set,
+                                 const float* in, float* out) {
+    int block = seg->block;
+    int bins = seg->bins;
+    int partitions = seg->partitions;
+    float* input = seg->input + channel * 2 * block;
+    float* fdl_re = seg->fdl_re + channel * partitions * bins;
+    float* fdl_im = seg->fdl_im + channel * partitions * bins;
+    const float* ir_re = seg->ir_re + ir_set * partitions * bins;
+    const float* ir_im = seg->ir_im + ir_set * partitions * bins;
+    float* acc_re = seg->acc_re;
+    float* acc_im = seg->acc_im;
+    int p, k;
+
+    // Slide the overlap-save window and transform into the delay line
+    memmove(input, input + block, block * sizeof(float));
+    memcpy(input + block, in, block * sizeof(float));
+    irix_audio_fft_forward(seg->fft, input, fdl_re + seg->fdl_pos * bins,
+                           fdl_im + seg->fdl_pos * bins);
+
+    // Multiply-accumulate every partition against its delayed spectrum
+    memset(acc_re, 0, bins * sizeof(float));
+    memset(acc_im, 0, bins * sizeof(float));
+    for (p = 0; p < partitions; p++) {
+        int slot = seg->fdl_pos - p;
+        const float* xr;
+        const float* xi;
+        const float* hr = ir_re + p * bins;
+        const float* hi = ir_im + p * bins;
+
+        if (slot < 0) slot += partitions;
+        xr = fdl_re + slot * bins;
+        xi = fdl_im + slot * bins;
+        for (k = 0; k < bins; k++) {
+            acc_re[k] += xr[k] * hr[k] - xi[k] * hi[k];
+            acc_im[k] += xr[k] * hi[k] + xi[k] * hr[k];
+        }
+    }
+
+    irix_audio_fft_inverse(seg->fft, acc_re, acc_im, seg->time);
+    memcpy(out, seg->time + block, block * sizeof(float));
+}
+
+// Step the delay line once all channels have been processed
+static void conv_segment_advance(ConvSegment* seg) {
+    if (++seg->fdl_pos == seg->partitions) seg->fdl_pos = 0;
+}
+
+// Compute tail job: input buffer (job % 2) into output ring half (job % 2)
+static void conv_run_tail(IrixAudioConvolver* conv, unsigned long job) {
+    int half = (int)(job & 1);
+    int tail_block = conv->tail_block;
+    int c;
+
+    for (c = 0; c < conv->channels; c++) {
+        conv_segment_process(&conv->tail, c, (conv->ir_channels == 1) ? 0 : c,
+                             conv->tail_in[half] + c * tail_block, conv->tail_channel_out);
+        memcpy(conv->tail_out + c * 2 * tail_block + half * tail_block,
+               conv->tail_channel_out, tail_block * sizeof(float));
+    }
+    conv_segment_advance(&conv->tail);
+}
+
+static void* conv_worker(void* arg) {
+    IrixAudioConvolver* conv = (IrixAudioConvolver*)arg;
+
+    for (;;) {
+        while (sem_wait(&conv->job_ready) != 0) {
+        }
+        if (conv->quit) break;
+        conv_run_tail(conv, conv->worker_jobs++);
+        sem_post(&conv->job_done);
+    }
+    return NULL;
+}
+
+// Create a convolver; ir holds ir_frames interleaved frames of 1 or channels channels
+IrixAudioConvolver* irix_audio_convolver_create(int channels, const float* ir, int ir_frames,
+                                                int ir_channels, IrixAudioConvolverParams* params) {
+    IrixAudioConvolver* conv;
+    int block, tail_block, head_length;
+
+    if (channels <= 0 || !ir || ir_frames <= 0 || !params ||
+        (ir_channels != 1 && ir_channels != channels)) {
+        irix_audio_set_error("Invalid convolver parameters");
+        return NULL;
+    }
+    block = params->block_frames;
+    tail_block = params->tail_block_frames;
+    if (block < 2 || (block & (block - 1)) != 0) {
+        irix_audio_set_error("Convolver block must be a power of two: %d", block);
+        return NULL;
+    }
+    if (tail_block != 0 &&
+        (tail_block <= block || (tail_block & (tail_block - 1)) != 0)) {
+        irix_audio_set_error("Convolver tail block must be a larger power of two: %d", tail_block);
+        return NULL;
+    }
+
+    conv = calloc(1, sizeof(IrixAudioConvolver));
+    if (!conv) {
+        irix_audio_set_error("Cannot allocate convolver");
+        return NULL;
+    }
+    conv->channels = channels;
+    conv->ir_channels = ir_channels;
+    conv->block = block;
+    conv->tail_block = tail_block;
+
+    // The tail starts two tail blocks in, leaving one tail block of time to compute it
+    conv->has_tail = (tail_block != 0 && ir_frames > 2 * tail_block);
+    head_length = conv->has_tail ? 2 * tail_block : ir_frames;
+
+    if (conv_segment_init(&conv->head, block, channels, ir, ir_frames, ir_channels,
+                          0, head_length) < 0) {
+        irix_audio_convolver_destroy(conv);
+        return NULL;
+    }
+    conv->stats.head_partitions = conv->head.partitions;
+
+    conv->channel_in = malloc(block * sizeof(float));
+    conv->channel_out = malloc(block * sizeof(float));
+    conv->fifo_in = calloc(block * channels, sizeof(float));
+    conv->fifo_out = calloc(block * channels, sizeof(float));
+    if (!conv->channel_in || !conv->channel_out || !conv->fifo_in || !conv->fifo_out) {
+        irix_audio_set_error("Cannot allocate convolver buffers");
+        irix_audio_convolver_destroy(conv);
+        return NULL;
+    }
+
+    if (conv->has_tail) {
+        if (conv_segment_init(&conv->tail, tail_block, channels, ir, ir_frames, ir_channels,
+                              head_length, ir_frames - head_length) < 0) {
+            irix_audio_convolver_destroy(conv);
+            return NULL;
+        }
+        conv->stats.tail_partitions = conv->tail.partitions;
+
+        conv->tail_in[0] = calloc(channels * tail_block, sizeof(float));
+        conv->tail_in[1] = calloc(channels * tail_block, sizeof(float));
+        conv->tail_out = calloc(channels * 2 * tail_block, sizeof(float));
+        conv->tail_channel_out = malloc(tail_block * sizeof(float));
+        if (!conv->tail_in[0] || !conv->tail_in[1] || !conv->tail_out || !conv->tail_channel_out) {
+            irix_audio_set_error("Cannot allocate convolver tail buffers");
+            irix_audio_convolver_destroy(conv);
+            return NULL;
+        }
+
+        if (params->background) {
+            sem_init(&conv->job_ready, 0, 0);
+            sem_init(&conv->job_done, 0, 0);
+            if (pthread_create(&conv->worker, NULL, conv_worker, conv) != 0) {
+                irix_audio_set_error("Cannot start convolver worker thread");
+                sem_destroy(&conv->job_ready);
+                sem_destroy(&conv->job_done);
+                irix_audio_convolver_destroy(conv);
+                return NULL;
+            }
+            conv->background = 1;
+            conv->worker_running = 1;
+        }
+    }
+
+    return conv;
+}
+
+// Destroy a convolver (detach it from any chain first)
+void irix_audio_convolver_destroy(IrixAudioConvolver* conv) {
+    if (!conv) return;
+
+    if (conv->worker_running) {
+        conv->quit = 1;
+        sem_post(&conv->job_ready);
+        pthread_join(conv->worker, NULL);
+        sem_destroy(&conv->job_ready);
+        sem_destroy(&conv->job_done);
+    }
+
+    conv_segment_free(&conv->head);
+    conv_segment_free(&conv->tail);
+    free(conv->channel_in);
+    free(conv->channel_out);
+    free(conv->fifo_in);
+    free(conv->fifo_out);
+    free(conv->tail_in[0]);
+    free(conv->tail_in[1]);
+    free(conv->tail_out);
+    free(conv->tail_channel_out);
+    free(conv);
+}
+
+// Wait for the tail job whose output starts at the current position
+static void conv_collect_tail(IrixAudioConvolver* conv) {
+    if (!conv->background) return;
+
+    if (sem_trywait(&conv->job_done) != 0) {
+        conv->stats.tail_waits++;
+        while (sem_wait(&conv->job_done) != 0) {
+        }
+    }
+}
+
+// Hand a full tail input block to the worker (or compute it inline)
+static void conv_submit_tail(IrixAudioConvolver* conv) {
+    unsigned long job = conv->tail_submitted++;
+
+    conv->stats.tail_jobs++;
+    if (conv->background) {
+        sem_post(&conv->job_ready);
+    } else {
+        conv_run_tail(conv, job);
+    }
+}
+
+// Convolve one interleaved block in place
+static void conv_process_block(IrixAudioConvolver* conv, float* frame) {
+    int block = conv->block;
+    int channels = conv->channels;
+    int ring = 0;
+    int c, i;
+
+    if (conv->has_tail) {
+        long tail_index = conv->position / conv->tail_block;
+        if (conv->position % conv->tail_block == 0 && tail_index >= 2) {
+            conv_collect_tail(conv);
+        }
+        ring = (int)(conv->position % (2 * conv->tail_block));
+    }
+
+    for (c = 0; c < channels; c++) {
+        for (i = 0; i < block; i++) {
+            conv->channel_in[i] = frame[i * channels + c];
+        }
+        if (conv->has_tail) {
+            memcpy(conv->tail_in[conv->tail_submitted & 1] + c * conv->tail_block + conv->tail_fill,
+                   conv->channel_in, block * sizeof(float));
+        }
+
+        conv_segment_process(&conv->head, c, (conv->ir_channels == 1) ? 0 : c,
+                             conv->channel_in, conv->channel_out);
+
+        if (conv->has_tail) {
+            const float* tail = conv->tail_out + c * 2 * conv->tail_block + ring;
+            for (i = 0; i < block; i++) {
+                frame[i * channels + c] = conv->channel_out[i] + tail[i];
+            }
+        } else {
+            for (i = 0; i < block; i++) {
+                frame[i * channels + c] = conv->channel_out[i];
+            }
+        }
+    }
+    conv_segment_advance(&conv->head);
+    conv->position += block;
+    conv->stats.blocks++;
+
+    if (conv->has_tail) {
+        conv->tail_fill += block;
+        if (conv->tail_fill == conv->tail_block) {
+            conv->tail_fill = 0;
+            conv_submit_tail(conv);
+        }
+    }
+}
+
+// Convolve interleaved frames in place; output lags the input by one block
+int irix_audio_convolver_process(IrixAudioConvolver* conv, float* buffer, int frames) {
+    int done = 0;
+
+    if (!conv || !buffer || frames < 0) {
+        irix_audio_set_error("Invalid convolver buffer");
+        return -1;
+    }
+
+    while (done < frames) {
+        int channels = conv->channels;
+        float* frame = buffer + done * channels;
+        int length = conv->block - conv->fifo_fill;
+        size_t bytes;
+
+        if (length > frames - done) length = frames - done;
+        bytes = length * channels * sizeof(float);
+
+        // Queue the input and hand back the same span of the last block's output
+        memcpy(conv->fifo_in + conv->fifo_fill * channels, frame, bytes);
+        memcpy(frame, conv->fifo_out + conv->fifo_fill * channels, bytes);
+        conv->fifo_fill += length;
+        done += length;
+
+        if (conv->fifo_fill == conv->block) {
+            float* full = conv->fifo_in;
+
+            // The output half has been drained, so it takes the next input
+            conv_process_block(conv, full);
+            conv->fifo_in = conv->fifo_out;
+            conv->fifo_out = full;
+            conv->fifo_fill = 0;
+        }
+    }
+
+    return frames;
+}
+
+// Get convolver statistics
+int irix_audio_convolver_get_stats(IrixAudioConvolver* conv, IrixAudioConvolverStats* stats) {
+    if (!conv || !stats) {
+        irix_audio_set_error("Invalid convolver");
+        return -1;
+    }
+    *stats = conv->stats;
+    return 0;
+}
+
+int irix_audio_convolver_channels(IrixAudioConvolver* conv) {
+    return conv->channels;
+}
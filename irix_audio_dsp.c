@@ -0,0 +1,659 @@
+// IRIX Audio Library - Processing chain
+// Gain, biquad EQ, dynamics and channel matrix stages run per block on
+// interleaved float frames. Parameter changes travel through a lock-free
+// single-producer/single-consumer queue so the audio thread never locks
+// or allocates.
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DSP_MAX_NODES 16
+#define DSP_QUEUE_SIZE 64           // Pending parameter changes (power of two)
+#define DSP_DYNAMICS_BLOCK 16       // Frames per dynamics gain update
+#define DSP_DENORMAL 1e-20f         // Filter state below this is flushed to zero
+
+typedef enum {
+    DSP_GAIN,
+    DSP_EQ,
+    DSP_DYNAMICS,
+    DSP_MATRIX,
+    DSP_CONVOLVER
+} DspType;
+
+// Gain with a linear ramp toward the target
+typedef struct {
+    float current;
+    float target;
+    float step;
+    int ramp_frames;
+    int remaining;
+} DspGain;
+
+// One biquad section (transposed direct form II)
+typedef struct {
+    int enabled;
+    float b0, b1, b2, a1, a2;
+} DspBiquad;
+
+typedef struct {
+    int bands;
+    DspBiquad* coef;
+    float* state;               // bands * channels * 2
+} DspEq;
+
+// Feed-forward compressor/limiter, channels linked
+typedef struct {
+    float threshold_db;
+    float slope;                // 1 - 1/ratio
+    float attack;               // Envelope coefficients per frame
+    float release;
+    float makeup_db;
+    float envelope;
+    float gain;
+} DspDynamics;
+
+typedef struct {
+    float* gains;               // [out * channels + in]
+    float* frame;
+} DspMatrix;
+
+typedef struct {
+    DspType type;
+    union {
+        DspGain gain;
+        DspEq eq;
+        DspDynamics dynamics;
+        DspMatrix matrix;
+        IrixAudioConvolver* convolver;
+    } u;
+} DspNode;
+
+// Parameter change, computed on the control thread
+typedef struct {
+    int node;
+    int index;                  // EQ band or matrix cell
+    int enabled;                // EQ band on/off
+    float values[5];
+} DspCommand;
+
+struct IrixAudioChain {
+    int channels;
+    int sample_rate;
+    int max_frames;
+    DspNode nodes[DSP_MAX_NODES];
+    int node_count;
+    int attached;
+
+    // Command queue: head written by the control thread, tail by the audio thread
+    DspCommand queue[DSP_QUEUE_SIZE];
+    volatile unsigned int queue_head;
+    volatile unsigned int queue_tail;
+
+    float* scratch;             // Write path staging, max_frames * channels
+};
+
+static float dsp_db_to_gain(double db) {
+    return (float)pow(10.0, db / 20.0);
+}
+
+// Envelope coefficient for a time constant in milliseconds
+static float dsp_time_coef(IrixAudioChain* chain, double ms) {
+    if (ms <= 0.0) return 0.0f;
+    return (float)exp(-1.0 / (ms * 0.001 * chain->sample_rate));
+}
+
+// Create a processing chain
+IrixAudioChain* irix_audio_chain_create(int channels, int sample_rate, int max_frames) {
+    IrixAudioChain* chain;
+
+    if (channels <= 0 || sample_rate <= 0 || max_frames <= 0) {
+        irix_audio_set_error("Invalid chain parameters");
+        return NULL;
+    }
+
+    chain = calloc(1, sizeof(IrixAudioChain));
+    if (!chain) {
+        irix_audio_set_error("Cannot allocate chain");
+        return NULL;
+    }
+    chain->channels = channels;
+    chain->sample_rate = sample_rate;
+    chain->max_frames = max_frames;
+    chain->scratch = malloc(max_frames * channels * sizeof(float));
+    if (!chain->scratch) {
+        irix_audio_set_error("Cannot allocate chain buffer");
+        free(chain);
+        return NULL;
+    }
+
+    return chain;
+}
+
+// Destroy a chain (detach it from its stream first)
+void irix_audio_chain_destroy(IrixAudioChain* chain) {
+    int i;
+
+    if (!chain) return;
+
+    for (i = 0; i < chain->node_count; i++) {
+        DspNode* node = &chain->nodes[i];
+        if (node->type == DSP_EQ) {
+            free(node->u.eq.coef);
+            free(node->u.eq.state);
+        } else if (node->type == DSP_MATRIX) {
+            free(node->u.matrix.gains);
+            free(node->u.matrix.frame);
+        }
+    }
+    free(chain->scratch);
+    free(chain);
+}
+
+// Reserve the next node slot
+static DspNode* dsp_new_node(IrixAudioChain* chain, DspType type) {
+    DspNode* node;
+
+    if (!chain) {
+        irix_audio_set_error("Invalid chain");
+        return NULL;
+    }
+    if (chain->attached) {
+        irix_audio_set_error("Cannot add stages to an attached chain");
+        return NULL;
+    }
+    if (chain->node_count >= DSP_MAX_NODES) {
+        irix_audio_set_error("Chain is full (%d stages)", DSP_MAX_NODES);
+        return NULL;
+    }
+
+    node = &chain->nodes[chain->node_count];
+    memset(node, 0, sizeof(DspNode));
+    node->type = type;
+    return node;
+}
+
+// Add a gain stage; returns the node index
+int irix_audio_chain_add_gain(IrixAudioChain* chain, double gain_db, double ramp_ms) {
+    DspNode* node = dsp_new_node(chain, DSP_GAIN);
+    if (!node) return -1;
+
+    node->u.gain.current = dsp_db_to_gain(gain_db);
+    node->u.gain.target = node->u.gain.current;
+    node->u.gain.ramp_frames = (int)(ramp_ms * 0.001 * chain->sample_rate);
+    if (node->u.gain.ramp_frames < 1) node->u.gain.ramp_frames = 1;
+    return chain->node_count++;
+}
+
+// Add an EQ bank with all bands off; returns the node index
+int irix_audio_chain_add_eq(IrixAudioChain* chain, int bands) {
+    DspNode* node;
+
+    if (bands <= 0) {
+        irix_audio_set_error("Invalid EQ band count: %d", bands);
+        return -1;
+    }
+    node = dsp_new_node(chain, DSP_EQ);
+    if (!node) return -1;
+
+    node->u.eq.bands = bands;
+    node->u.eq.coef = calloc(bands, sizeof(DspBiquad));
+    node->u.eq.state = calloc(bands * chain->channels * 2, sizeof(float));
+    if (!node->u.eq.coef || !node->u.eq.state) {
+        free(node->u.eq.coef);
+        free(node->u.eq.state);
+        irix_audio_set_error("Cannot allocate EQ bank");
+        return -1;
+    }
+    return chain->node_count++;
+}
+
+// Add a compressor (ratio > 1) or limiter (very large ratio); returns the node index
+int irix_audio_chain_add_dynamics(IrixAudioChain* chain, double threshold_db, double ratio,
+                                  double attack_ms, double release_ms, double makeup_db) {
+    DspNode* node;
+
+    if (ratio < 1.0) {
+        irix_audio_set_error("Invalid dynamics ratio: %f", ratio);
+        return -1;
+    }
+    node = dsp_new_node(chain, DSP_DYNAMICS);
+    if (!node) return -1;
+
+    node->u.dynamics.threshold_db = (float)threshold_db;
+    node->u.dynamics.slope = (float)(1.0 - 1.0 / ratio);
+    node->u.dynamics.attack = dsp_time_coef(chain, attack_ms);
+    node->u.dynamics.release = dsp_time_coef(chain, release_ms);
+    node->u.dynamics.makeup_db = (float)makeup_db;
+    node->u.dynamics.gain = dsp_db_to_gain(makeup_db);
+    return chain->node_count++;
+}
+
+// Add a channel matrix, initially identity; returns the node index
+int irix_audio_chain_add_matrix(IrixAudioChain* chain) {
+    DspNode* node = dsp_new_node(chain, DSP_MATRIX);
+    int i;
+
+    if (!node) return -1;
+
+    node->u.matrix.gains = calloc(chain->channels * chain->channels, sizeof(float));
+    node->u.matrix.frame = calloc(chain->channels, sizeof(float));
+    if (!node->u.matrix.gains || !node->u.matrix.frame) {
+        free(node->u.matrix.gains);
+        free(node->u.matrix.frame);
+        irix_audio_set_error("Cannot allocate channel matrix");
+        return -1;
+    }
+    for (i = 0; i < chain->channels; i++) {
+        node->u.matrix.gains[i * chain->channels + i] = 1.0f;
+    }
+    return chain->node_count++;
+}
+
+// Add a convolution stage; the convolver stays owned by the caller.
+// It delays the chain's output by one convolver block.
+int irix_audio_chain_add_convolver(IrixAudioChain* chain, IrixAudioConvolver* conv) {
+    DspNode* node;
+
+    if (!chain || !conv || irix_audio_convolver_channels(conv) != chain->channels) {
+        irix_audio_set_error("Convolver does not match chain");
+        return -1;
+    }
+    node = dsp_new_node(chain, DSP_CONVOLVER);
+    if (!node) return -1;
+
+    node->u.convolver = conv;
+    return chain->node_count++;
+}
+
+// Queue a parameter change (control thread)
+static int dsp_push(IrixAudioChain* chain, int node, DspType type, DspCommand* command) {
+    unsigned int head;
+
+    if (!chain || node < 0 || node >= chain->node_count || chain->nodes[node].type != type) {
+        irix_audio_set_error("Invalid chain stage: %d", node);
+        return -1;
+    }
+
+    head = chain->queue_head;
+    if (head - chain->queue_tail >= DSP_QUEUE_SIZE) {
+        irix_audio_set_error("Chain command queue is full");
+        return -1;
+    }
+
+    command->node = node;
+    chain->queue[head & (DSP_QUEUE_SIZE - 1)] = *command;
+    IRIX_AUDIO_BARRIER();
+    chain->queue_head = head + 1;
+    return 0;
+}
+
+// Ramp a gain stage to a new level
+int irix_audio_chain_set_gain(IrixAudioChain* chain, int node, double gain_db) {
+    DspCommand command;
+
+    command.index = 0;
+    command.values[0] = dsp_db_to_gain(gain_db);
+    return dsp_push(chain, node, DSP_GAIN, &command);
+}
+
+// Configure one EQ band (RBJ cookbook coefficients)
+int irix_audio_chain_set_eq_band(IrixAudioChain* chain, int node, int band, IrixAudioEqShape shape,
+                                 double freq_hz, double q, double gain_db) {
+    DspCommand command;
+    double w0, cosw, alpha, a, b0, b1, b2, a0, a1, a2, sq;
+
+    if (!chain || node < 0 || node >= chain->node_count || chain->nodes[node].type != DSP_EQ ||
+        band < 0 || band >= chain->nodes[node].u.eq.bands) {
+        irix_audio_set_error("Invalid EQ band: %d", band);
+        return -1;
+    }
+    if (shape != IRIX_AUDIO_EQ_OFF &&
+        (freq_hz <= 0.0 || freq_hz >= chain->sample_rate / 2.0 || q <= 0.0)) {
+        irix_audio_set_error("Invalid EQ frequency or Q");
+        return -1;
+    }
+
+    command.index = band;
+    command.enabled = (shape != IRIX_AUDIO_EQ_OFF);
+    if (shape == IRIX_AUDIO_EQ_OFF) {
+        memset(command.values, 0, sizeof(command.values));
+        return dsp_push(chain, node, DSP_EQ, &command);
+    }
+
+    w0 = 2.0 * M_PI * freq_hz / chain->sample_rate;
+    cosw = cos(w0);
+    alpha = sin(w0) / (2.0 * q);
+    a = pow(10.0, gain_db / 40.0);
+
+    switch (shape) {
+    case IRIX_AUDIO_EQ_PEAK:
+        b0 = 1.0 + alpha * a;
+        b1 = -2.0 * cosw;
+        b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha / a;
+        break;
+    case IRIX_AUDIO_EQ_LOW_SHELF:
+        sq = 2.0 * sqrt(a) * alpha;
+        b0 = a * ((a + 1.0) - (a - 1.0) * cosw + sq);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosw);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cosw - sq);
+        a0 = (a + 1.0) + (a - 1.0) * cosw + sq;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cosw);
+        a2 = (a + 1.0) + (a - 1.0) * cosw - sq;
+        break;
+    case IRIX_AUDIO_EQ_HIGH_SHELF:
+        sq = 2.0 * sqrt(a) * alpha;
+        b0 = a * ((a + 1.0) + (a - 1.0) * cosw + sq);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosw);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cosw - sq);
+        a0 = (a + 1.0) - (a - 1.0) * cosw + sq;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cosw);
+        a2 = (a + 1.0) - (a - 1.0) * cosw - sq;
+        break;
+    case IRIX_AUDIO_EQ_LOW_PASS:
+        b0 = (1.0 - cosw) / 2.0;
+        b1 = 1.0 - cosw;
+        b2 = (1.0 - cosw) / 2.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha;
+        break;
+    case IRIX_AUDIO_EQ_HIGH_PASS:
+        b0 = (1.0 + cosw) / 2.0;
+        b1 = -(1.0 + cosw);
+        b2 = (1.0 + cosw) / 2.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha;
+        break;
+    default:
+        irix_audio_set_error("Invalid EQ shape: %d", (int)shape);
+        return -1;
+    }
+
+    command.values[0] = (float)(b0 / a0);
+    command.values[1] = (float)(b1 / a0);
+    command.values[2] = (float)(b2 / a0);
+    command.values[3] = (float)(a1 / a0);
+    command.values[4] = (float)(a2 / a0);
+    return dsp_push(chain, node, DSP_EQ, &command);
+}
+
+// Change compressor/limiter settings
+int irix_audio_chain_set_dynamics(IrixAudioChain* chain, int node, double threshold_db, double ratio,
+                                  double attack_ms, double release_ms, double makeup_db) {
+    DspCommand command;
+
+    if (!chain || ratio < 1.0) {
+        irix_audio_set_error("Invalid dynamics ratio: %f", ratio);
+        return -1;
+    }
+
+    command.index = 0;
+    command.values[0] = (float)threshold_db;
+    command.values[1] = (float)(1.0 - 1.0 / ratio);
+    command.values[2] = dsp_time_coef(chain, attack_ms);
+    command.values[3] = dsp_time_coef(chain, release_ms);
+    command.values[4] = (float)makeup_db;
+    return dsp_push(chain, node, DSP_DYNAMICS, &command);
+}
+
+// Set the gain from one input channel to one output channel
+int irix_audio_chain_set_matrix(IrixAudioChain* chain, int node, int out_channel, int in_channel,
+                                double gain) {
+    DspCommand command;
+
+    if (!chain || out_channel < 0 || out_channel >= chain->channels ||
+        in_channel < 0 || in_channel >= chain->channels) {
+        irix_audio_set_error("Invalid matrix cell: %d, %d", out_channel, in_channel);
+        return -1;
+    }
+
+    command.index = out_channel * chain->channels + in_channel;
+    command.values[0] = (float)gain;
+    return dsp_push(chain, node, DSP_MATRIX, &command);
+}
+
+// Apply queued parameter changes (audio thread)
+static void dsp_drain(IrixAudioChain* chain) {
+    unsigned int tail = chain->queue_tail;
+    unsigned int head = chain->queue_head;
+
+    IRIX_AUDIO_BARRIER();
+    while (tail != head) {
+        DspCommand* command = &chain->queue[tail & (DSP_QUEUE_SIZE - 1)];
+        DspNode* node = &chain->nodes[command->node];
+
+        switch (node->type) {
+        case DSP_GAIN: {
+            DspGain* g = &node->u.gain;
+            g->target = command->values[0];
+            g->remaining = g->ramp_frames;
+            g->step = (g->target - g->current) / g->ramp_frames;
+            break;
+        }
+        case DSP_EQ: {
+            DspBiquad* b = &node->u.eq.coef[command->index];
+            b->enabled = command->enabled;
+            b->b0 = command->values[0];
+            b->b1 = command->values[1];
+            b->b2 = command->values[2];
+            b->a1 = command->values[3];
+            b->a2 = command->values[4];
+            break;
+        }
+        case DSP_DYNAMICS: {
+            DspDynamics* d = &node->u.dynamics;
+            d->threshold_db = command->values[0];
+            d->slope = command->values[1];
+            d->attack = command->values[2];
+            d->release = command->values[3];
+            d->makeup_db = command->values[4];
+            break;
+        }
+        case DSP_MATRIX:
+            node->u.matrix.gains[command->index] = command->values[0];
+            break;
+        case DSP_CONVOLVER:
+            break;
+        }
+        tail++;
+    }
+    IRIX_AUDIO_BARRIER();
+    chain->queue_tail = tail;
+}
+
+// Gain kernel: per-frame while ramping, then a flat unrolled multiply
+static void dsp_run_gain(DspGain* g, float* buffer, int frames, int channels) {
+    int n = frames * channels;
+    int f = 0, i, c;
+    float k;
+
+    for (; f < frames && g->remaining > 0; f++) {
+        g->current += g->step;
+        if (--g->remaining == 0) g->current = g->target;
+        for (c = 0; c < channels; c++) {
+            buffer[f * channels + c] *= g->current;
+        }
+    }
+
+    k = g->current;
+    if (k == 1.0f) return;
+    i = f * channels;
+    for (; i + 4 <= n; i += 4) {
+        buffer[i] *= k;
+        buffer[i + 1] *= k;
+        buffer[i + 2] *= k;
+        buffer[i + 3] *= k;
+    }
+    for (; i < n; i++) {
+        buffer[i] *= k;
+    }
+}
+
+// EQ kernel: each band runs over a whole channel before the next
+static void dsp_run_eq(DspEq* eq, float* buffer, int frames, int channels) {
+    int band, c, f;
+
+    for (band = 0; band < eq->bands; band++) {
+        DspBiquad* b = &eq->coef[band];
+        if (!b->enabled) continue;
+
+        for (c = 0; c < channels; c++) {
+            float* state = &eq->state[(band * channels + c) * 2];
+            float z1 = state[0], z2 = state[1];
+            float* x = buffer + c;
+
+            for (f = 0; f < frames; f++) {
+                float in = x[f * channels];
+                float out = b->b0 * in + z1;
+                z1 = b->b1 * in - b->a1 * out + z2;
+                z2 = b->b2 * in - b->a2 * out;
+                x[f * channels] = out;
+            }
+
+            // Denormals trap to software on MIPS; keep the state out of that range
+            state[0] = (fabsf(z1) < DSP_DENORMAL) ? 0.0f : z1;
+            state[1] = (fabsf(z2) < DSP_DENORMAL) ? 0.0f : z2;
+        }
+    }
+}
+
+// Dynamics kernel: per-frame envelope, gain interpolated across short blocks
+static void dsp_run_dynamics(DspDynamics* d, float* buffer, int frames, int channels) {
+    int start, f, c;
+
+    for (start = 0; start < frames; start += DSP_DYNAMICS_BLOCK) {
+        int length = frames - start;
+        float env_db, over, target, step;
+
+        if (length > DSP_DYNAMICS_BLOCK) length = DSP_DYNAMICS_BLOCK;
+
+        for (f = start; f < start + length; f++) {
+            float peak = 0.0f;
+            for (c = 0; c < channels; c++) {
+                float v = fabsf(buffer[f * channels + c]);
+                if (v > peak) peak = v;
+            }
+            if (peak > d->envelope) {
+                d->envelope = d->attack * d->envelope + (1.0f - d->attack) * peak;
+            } else {
+                d->envelope = d->release * d->envelope + (1.0f - d->release) * peak;
+            }
+        }
+        if (d->envelope < DSP_DENORMAL) d->envelope = 0.0f;
+
+        env_db = 20.0f * log10f(d->envelope + 1e-12f);
+        over = env_db - d->threshold_db;
+        target = (over > 0.0f) ? -over * d->slope : 0.0f;
+        target = powf(10.0f, (target + d->makeup_db) / 20.0f);
+        step = (target - d->gain) / length;
+
+        for (f = start; f < start + length; f++) {
+            d->gain += step;
+            for (c = 0; c < channels; c++) {
+                buffer[f * channels + c] *= d->gain;
+            }
+        }
+        d->gain = target;
+    }
+}
+
+// Matrix kernel
+static void dsp_run_matrix(DspMatrix* m, float* buffer, int frames, int channels) {
+    int f, o, i;
+
+    for (f = 0; f < frames; f++) {
+        float* frame = buffer + f * channels;
+        memcpy(m->frame, frame, channels * sizeof(float));
+        for (o = 0; o < channels; o++) {
+            const float* row = m->gains + o * channels;
+            float sum = 0.0f;
+            for (i = 0; i < channels; i++) {
+                sum += row[i] * m->frame[i];
+            }
+            frame[o] = sum;
+        }
+    }
+}
+
+// Start a gain ramp now (audio thread, between blocks)
+int irix_audio_chain_apply_gain(IrixAudioChain* chain, int node, double gain_db) {
+    DspGain* g;
+
+    if (!chain || node < 0 || node >= chain->node_count || chain->nodes[node].type != DSP_GAIN) {
+        return -1;
+    }
+    g = &chain->nodes[node].u.gain;
+    g->target = dsp_db_to_gain(gain_db);
+    g->remaining = g->ramp_frames;
+    g->step = (g->target - g->current) / g->ramp_frames;
+    return 0;
+}
+
+// Process interleaved frames in place
+int irix_audio_chain_process(IrixAudioChain* chain, float* buffer, int frames) {
+    int i;
+
+    if (!chain || !buffer || frames < 0) {
+        irix_audio_set_error("Invalid chain");
+        return -1;
+    }
+
+    dsp_drain(chain);
+
+    for (i = 0; i < chain->node_count; i++) {
+        DspNode* node = &chain->nodes[i];
+        switch (node->type) {
+        case DSP_GAIN:
+            dsp_run_gain(&node->u.gain, buffer, frames, chain->channels);
+            break;
+        case DSP_EQ:
+            dsp_run_eq(&node->u.eq, buffer, frames, chain->channels);
+            break;
+        case DSP_DYNAMICS:
+            dsp_run_dynamics(&node->u.dynamics, buffer, frames, chain->channels);
+            break;
+        case DSP_MATRIX:
+            dsp_run_matrix(&node->u.matrix, buffer, frames, chain->channels);
+            break;
+        case DSP_CONVOLVER:
+            if (irix_audio_convolver_process(node->u.convolver, buffer, frames) < 0) return -1;
+            break;
+        }
+    }
+
+    return frames;
+}
+
+// Copy up to max_frames into the staging buffer and process them
+int irix_audio_chain_stage(IrixAudioChain* chain, const float* buffer, int frames, float** staged) {
+    if (frames > chain->max_frames) frames = chain->max_frames;
+
+    memcpy(chain->scratch, buffer, frames * chain->channels * sizeof(float));
+    if (irix_audio_chain_process(chain, chain->scratch, frames) < 0) return -1;
+    *staged = chain->scratch;
+    return frames;
+}
+
+// Attach a chain to a stream's write (output) or read (input) path
+int irix_audio_chain_attach(IrixAudioStream* stream, IrixAudioChain* chain) {
+    if (!stream) {
+        irix_audio_set_error("Invalid stream");
+        return -1;
+    }
+    if (chain && (chain->channels != stream->channels || chain->sample_rate != stream->sample_rate)) {
+        irix_audio_set_error("Chain does not match stream");
+        return -1;
+    }
+
+    if (stream->chain) stream->chain->attached = 0;
+    stream->chain = chain;
+    if (chain) chain->attached = 1;
+    return 0;
+}
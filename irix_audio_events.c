@@ -0,0 +1,206 @@
+// IRIX Audio Library - Timestamped event queue
+// Events are keyed by absolute stream frame. The control thread posts
+// them through a lock-free single-producer/single-consumer ring; the
+// audio thread moves them into a list sorted by frame and, through
+// irix_audio_events_run, tells the stream I/O paths where to split each
+// period so every event lands on its exact frame. Markers travel back to
+// the control thread through a second ring.
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct IrixAudioEvents {
+    int capacity;                   // Power of two
+
+    // Posted events: head written by the control thread, tail by the audio thread
+    IrixAudioEvent* inbound;
+    volatile unsigned int inbound_head;
+    volatile unsigned int inbound_tail;
+
+    // Due events sorted by frame (audio thread)
+    IrixAudioEvent* pending;
+    int pending_count;
+
+    // Reached markers: head written by the audio thread, tail by the control thread
+    IrixAudioEvent* markers;
+    volatile unsigned int marker_head;
+    volatile unsigned int marker_tail;
+
+    IrixAudioEventStats stats;
+};
+
+// Create a queue holding up to capacity events in each direction
+IrixAudioEvents* irix_audio_events_create(int capacity) {
+    IrixAudioEvents* events;
+    int size = 16;
+
+    while (size < capacity) size <<= 1;
+
+    events = calloc(1, sizeof(IrixAudioEvents));
+    if (!events) {
+        irix_audio_set_error("Cannot allocate event queue");
+        return NULL;
+    }
+    events->capacity = size;
+    events->inbound = calloc(size, sizeof(IrixAudioEvent));
+    events->pending = calloc(size, sizeof(IrixAudioEvent));
+    events->markers = calloc(size, sizeof(IrixAudioEvent));
+    if (!events->inbound || !events->pending || !events->markers) {
+        irix_audio_set_error("Cannot allocate event queue");
+        irix_audio_events_destroy(events);
+        return NULL;
+    }
+
+    return events;
+}
+
+void irix_audio_events_destroy(IrixAudioEvents* events) {
+    if (!events) return;
+
+    free(events->inbound);
+    free(events->pending);
+    free(events->markers);
+    free(events);
+}
+
+// Attach a queue to a stream; detach with NULL once I/O has stopped
+int irix_audio_events_attach(IrixAudioStream* stream, IrixAudioEvents* events) {
+    if (!stream) {
+        irix_audio_set_error("Invalid stream");
+        return -1;
+    }
+    stream->events = events;
+    return 0;
+}
+
+// Queue an event (control thread)
+int irix_audio_events_post(IrixAudioEvents* events, const IrixAudioEvent* event) {
+    unsigned int head;
+
+    if (!events || !event) {
+        irix_audio_set_error("Invalid event queue");
+        return -1;
+    }
+    if (event->type == IRIX_AUDIO_EVENT_CALLBACK && !event->callback) {
+        irix_audio_set_error("Callback event without a callback");
+        return -1;
+    }
+
+    head = events->inbound_head;
+    if (head - events->inbound_tail >= (unsigned int)events->capacity) {
+        irix_audio_set_error("Event queue is full");
+        return -1;
+    }
+
+    events->inbound[head & (events->capacity - 1)] = *event;
+    IRIX_AUDIO_BARRIER();
+    events->inbound_head = head + 1;
+    events->stats.posted++;
+    return 0;
+}
+
+// Take the next reached marker (control thread); returns 1 if one was taken
+int irix_audio_events_poll(IrixAudioEvents* events, IrixAudioEvent* marker) {
+    unsigned int tail;
+
+    if (!events || !marker) {
+        irix_audio_set_error("Invalid event queue");
+        return -1;
+    }
+
+    tail = events->marker_tail;
+    if (tail == events->marker_head) return 0;
+    IRIX_AUDIO_BARRIER();
+    *marker = events->markers[tail & (events->capacity - 1)];
+    IRIX_AUDIO_BARRIER();
+    events->marker_tail = tail + 1;
+    return 1;
+}
+
+int irix_audio_events_get_stats(IrixAudioEvents* events, IrixAudioEventStats* stats) {
+    if (!events || !stats) {
+        irix_audio_set_error("Invalid event queue");
+        return -1;
+    }
+    *stats = events->stats;
+    stats->pending = (int)(events->inbound_head - events->inbound_tail) + events->pending_count;
+    return 0;
+}
+
+// Move posted events into the sorted list; equal frames keep post order
+static void events_drain(IrixAudioEvents* events) {
+    unsigned int tail = events->inbound_tail;
+    unsigned int head = events->inbound_head;
+
+    IRIX_AUDIO_BARRIER();
+    while (tail != head && events->pending_count < events->capacity) {
+        const IrixAudioEvent* event = &events->inbound[tail & (events->capacity - 1)];
+        int i = events->pending_count;
+
+        while (i > 0 && events->pending[i - 1].frame > event->frame) {
+            events->pending[i] = events->pending[i - 1];
+            i--;
+        }
+        events->pending[i] = *event;
+        events->pending_count++;
+        tail++;
+    }
+    IRIX_AUDIO_BARRIER();
+    events->inbound_tail = tail;
+}
+
+static void events_apply(IrixAudioEvents* events, IrixAudioStream* stream, const IrixAudioEvent* event) {
+    unsigned int head;
+
+    switch (event->type) {
+    case IRIX_AUDIO_EVENT_GAIN:
+        if (irix_audio_chain_apply_gain(stream->chain, event->node, event->gain_db) < 0) {
+            events->stats.dropped++;
+            return;
+        }
+        break;
+    case IRIX_AUDIO_EVENT_CALLBACK:
+        event->callback(event->user, event);
+        break;
+    case IRIX_AUDIO_EVENT_MARKER:
+        head = events->marker_head;
+        if (head - events->marker_tail >= (unsigned int)events->capacity) {
+            events->stats.markers_lost++;
+            break;
+        }
+        events->markers[head & (events->capacity - 1)] = *event;
+        IRIX_AUDIO_BARRIER();
+        events->marker_head = head + 1;
+        break;
+    }
+    events->stats.applied++;
+}
+
+int irix_audio_events_run(IrixAudioEvents* events, IrixAudioStream* stream, long long position,
+                          int frames) {
+    int due = 0;
+
+    events_drain(events);
+
+    while (due < events->pending_count && events->pending[due].frame <= position) {
+        if (events->pending[due].frame < position) events->stats.late++;
+        events_apply(events, stream, &events->pending[due]);
+        due++;
+    }
+    if (due > 0) {
+        events->pending_count -= due;
+        memmove(events->pending, events->pending + due, events->pending_count * sizeof(IrixAudioEvent));
+    }
+
+    if (events->pending_count > 0 && events->pending[0].frame - position < frames) {
+        frames = (int)(events->pending[0].frame - position);
+    }
+    return frames;
+}
+
+long long irix_audio_events_next(IrixAudioEvents* events) {
+    events_drain(events);
+    return (events->pending_count > 0) ? events->pending[0].frame : -1;
+}
@@ -0,0 +1,172 @@
+// IRIX Audio Library - Real FFT
+// Radix-2 complex FFT on split real/imaginary arrays with precomputed
+// twiddle and bit-reversal tables; a real transform of size N runs as a
+// complex transform of size N/2 plus a split pass.
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <math.h>
+#include <stdlib.h>
+
+struct IrixAudioFft {
+    int size;                   // Real transform size N
+    int half;                   // Complex transform size M = N / 2
+    int* bitrev;                // M entries
+    float* cos_table;           // cos(2 pi k / M), k < M / 2
+    float* sin_table;           // sin(2 pi k / M)
+    float* split_cos;           // cos(2 pi k / N), k <= M
+    float* split_sin;           // sin(2 pi k / N)
+    float* zr;                  // Complex work arrays, M entries
+    float* zi;
+};
+
+// Create a real FFT of a power-of-two size (at least 4)
+IrixAudioFft* irix_audio_fft_create(int size) {
+    IrixAudioFft* fft;
+    int bits = 0, i, j;
+
+    if (size < 4 || (size & (size - 1)) != 0) {
+        irix_audio_set_error("FFT size must be a power of two: %d", size);
+        return NULL;
+    }
+
+    fft = calloc(1, sizeof(IrixAudioFft));
+    if (!fft) {
+        irix_audio_set_error("Cannot allocate FFT");
+        return NULL;
+    }
+    fft->size = size;
+    fft->half = size / 2;
+    fft->bitrev = malloc(fft->half * sizeof(int));
+    fft->cos_table = malloc(fft->half / 2 * sizeof(float));
+    fft->sin_table = malloc(fft->half / 2 * sizeof(float));
+    fft->split_cos = malloc((fft->half + 1) * sizeof(float));
+    fft->split_sin = malloc((fft->half + 1) * sizeof(float));
+    fft->zr = malloc(fft->half * sizeof(float));
+    fft->zi = malloc(fft->half * sizeof(float));
+    if (!fft->bitrev || !fft->cos_table || !fft->sin_table || !fft->split_cos ||
+        !fft->split_sin || !fft->zr || !fft->zi) {
+        irix_audio_set_error("Cannot allocate FFT tables");
+        irix_audio_fft_destroy(fft);
+        return NULL;
+    }
+
+    while ((1 << bits) < fft->half) bits++;
+    for (i = 0; i < fft->half; i++) {
+        int r = 0;
+        for (j = 0; j < bits; j++) {
+            if (i & (1 << j)) r |= 1 << (bits - 1 - j);
+        }
+        fft->bitrev[i] = r;
+    }
+    for (i = 0; i < fft->half / 2; i++) {
+        fft->cos_table[i] = (float)cos(2.0 * M_PI * i / fft->half);
+        fft->sin_table[i] = (float)sin(2.0 * M_PI * i / fft->half);
+    }
+    for (i = 0; i <= fft->half; i++) {
+        fft->split_cos[i] = (float)cos(2.0 * M_PI * i / size);
+        fft->split_sin[i] = (float)sin(2.0 * M_PI * i / size);
+    }
+
+    return fft;
+}
+
+void irix_audio_fft_destroy(IrixAudioFft* fft) {
+    if (!fft) return;
+
+    free(fft->bitrev);
+    free(fft->cos_table);
+    free(fft->sin_table);
+    free(fft->split_cos);
+    free(fft->split_sin);
+    free(fft->zr);
+    free(fft->zi);
+    free(fft);
+}
+
+int irix_audio_fft_size(IrixAudioFft* fft) {
+    return fft->size;
+}
+
+// In-place complex FFT on bit-reversed input; sign -1 forward, +1 inverse
+static void fft_complex(IrixAudioFft* fft, float* re, float* im, float sign) {
+    int m = fft->half;
+    int span, start, k;
+
+    for (span = 1; span < m; span <<= 1) {
+        int stride = m / (span << 1);
+        for (start = 0; start < m; start += span << 1) {
+            float* ar = re + start;
+            float* ai = im + start;
+            float* br = ar + span;
+            float* bi = ai + span;
+            for (k = 0; k < span; k++) {
+                float wr = fft->cos_table[k * stride];
+                float wi = sign * fft->sin_table[k * stride];
+                float tr = br[k] * wr - bi[k] * wi;
+                float ti = br[k] * wi + bi[k] * wr;
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+}
+
+// Forward transform: size real samples to size / 2 + 1 complex bins
+void irix_audio_fft_forward(IrixAudioFft* fft, const float* in, float* re, float* im) {
+    int m = fft->half;
+    float* zr = fft->zr;
+    float* zi = fft->zi;
+    int k;
+
+    // Pack even/odd samples as one complex sequence, bit-reversed
+    for (k = 0; k < m; k++) {
+        zr[fft->bitrev[k]] = in[2 * k];
+        zi[fft->bitrev[k]] = in[2 * k + 1];
+    }
+    fft_complex(fft, zr, zi, -1.0f);
+
+    // Split into the spectra of the even and odd samples and combine
+    for (k = 0; k <= m; k++) {
+        int a = (k == m) ? 0 : k;
+        int b = (k == 0) ? 0 : m - k;
+        float er = 0.5f * (zr[a] + zr[b]);
+        float ei = 0.5f * (zi[a] - zi[b]);
+        float orr = 0.5f * (zi[a] + zi[b]);
+        float oi = -0.5f * (zr[a] - zr[b]);
+        float wr = fft->split_cos[k];
+        float wi = -fft->split_sin[k];
+        re[k] = er + orr * wr - oi * wi;
+        im[k] = ei + orr * wi + oi * wr;
+    }
+}
+
+// Inverse transform: size / 2 + 1 complex bins to size real samples, scaled
+void irix_audio_fft_inverse(IrixAudioFft* fft, const float* re, const float* im, float* out) {
+    int m = fft->half;
+    float* zr = fft->zr;
+    float* zi = fft->zi;
+    float scale = 1.0f / m;
+    int k;
+
+    for (k = 0; k < m; k++) {
+        float er = 0.5f * (re[k] + re[m - k]);
+        float ei = 0.5f * (im[k] - im[m - k]);
+        float dr = 0.5f * (re[k] - re[m - k]);
+        float di = 0.5f * (im[k] + im[m - k]);
+        float wr = fft->split_cos[k];
+        float wi = fft->split_sin[k];
+        float orr = dr * wr - di * wi;
+        float oi = dr * wi + di * wr;
+        zr[fft->bitrev[k]] = er - oi;
+        zi[fft->bitrev[k]] = ei + orr;
+    }
+    fft_complex(fft, zr, zi, 1.0f);
+
+    for (k = 0; k < m; k++) {
+        out[2 * k] = zr[k] * scale;
+        out[2 * k + 1] = zi[k] * scale;
+    }
+}
@@ -0,0 +1,662 @@
+// IRIX Audio Library - Lossless compressed capture
+// Writes FLAC files (fixed predictors, partitioned Rice residuals). The
+// capture thread only copies frames into a bounded ring of blocks; worker
+// threads encode blocks in parallel and write them out in order.
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FLAC_MAX_FIXED_ORDER 4
+#define FLAC_MAX_PARTITION_ORDER 8
+#define FLAC_MAX_RICE_PARAM 14      // 4-bit parameters, 15 is the escape code
+#define FLAC_STREAMINFO_SIZE 34
+
+// Block slot states
+#define SLOT_FREE 0                 // Owned by the capture thread
+#define SLOT_FILLED 1               // Waiting for a worker
+#define SLOT_ENCODING 2
+#define SLOT_ENCODED 3              // Waiting to be written in order
+
+typedef struct {
+    volatile int state;
+    int frames;
+    unsigned long frame_number;
+    int* samples;               // [channel][block_frames]
+    unsigned char* out;
+    int out_bytes;
+} FlacSlot;
+
+struct IrixAudioCapture {
+    IrixAudioCaptureParams params;
+    FILE* file;
+    FlacSlot* slots;
+    int out_capacity;
+
+    // Capture thread side
+    int fill_index;             // Slot being filled
+    int fill_frames;
+    int dropping;               // Current block is being dropped
+    unsigned long blocks_published;
+
+    // Worker side
+    pthread_t* workers;
+    int worker_count;
+    pthread_mutex_t claim_mutex;
+    pthread_mutex_t write_mutex;
+    sem_t work_ready;           // One post per published block, one per worker at close
+    int claim_index;
+    unsigned long blocks_claimed;
+    int write_index;
+    volatile int closing;
+    int finished;
+    int finish_result;
+    unsigned long long frames_encoded;
+    int min_frame_bytes;
+    int max_frame_bytes;
+
+    IrixAudioCaptureStats stats;
+};
+
+// CRC-8 (x^8 + x^2 + x + 1) and CRC-16 (x^16 + x^15 + x^2 + 1)
+static unsigned char flac_crc8_table[256];
+static unsigned short flac_crc16_table[256];
+static pthread_once_t flac_tables_once = PTHREAD_ONCE_INIT;
+
+static void flac_init_tables(void) {
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        unsigned int crc8 = i;
+        unsigned int crc16 = i << 8;
+        for (j = 0; j < 8; j++) {
+            crc8 = (crc8 & 0x80) ? ((crc8 << 1) ^ 0x07) : (crc8 << 1);
+            crc16 = (crc16 & 0x8000) ? ((crc16 << 1) ^ 0x8005) : (crc16 << 1);
+        }
+        flac_crc8_table[i] = (unsigned char)crc8;
+        flac_crc16_table[i] = (unsigned short)crc16;
+    }
+}
+
+static unsigned char flac_crc8(const unsigned char* data, int length) {
+    unsigned char crc = 0;
+    int i;
+
+    for (i = 0; i < length; i++) {
+        crc = flac_crc8_table[crc ^ data[i]];
+    }
+    return crc;
+}
+
+static unsigned short flac_crc16(const unsigned char* data, int length) {
+    unsigned short crc = 0;
+    int i;
+
+    for (i = 0; i < length; i++) {
+        crc = (unsigned short)((crc << 8) ^ flac_crc16_table[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+// MSB-first bit writer
+typedef struct {
+    unsigned char* data;
+    int bytes;
+    unsigned long long acc;
+    int bits;                   // Bits held in acc
+} FlacBits;
+
+static void bits_init(FlacBits* bw, unsigned char* data) {
+    bw->data = data;
+    bw->bytes = 0;
+    bw->acc = 0;
+    bw->bits = 0;
+}
+
+// Write the low count bits of value (count <= 32)
+static void bits_put(FlacBits* bw, unsigned int value, int count) {
+    if (count == 0) return;
+    bw->acc = (bw->acc << count) | (value & (0xffffffffu >> (32 - count)));
+    bw->bits += count;
+    while (bw->bits >= 8) {
+        bw->bits -= 8;
+        bw->data[bw->bytes++] = (unsigned char)(bw->acc >> bw->bits);
+    }
+}
+
+static void bits_put_signed(FlacBits* bw, int value, int count) {
+    bits_put(bw, (unsigned int)value, count);
+}
+
+static void bits_put_zeros(FlacBits* bw, unsigned int count) {
+    while (count >= 32) {
+        bits_put(bw, 0, 32);
+        count -= 32;
+    }
+    bits_put(bw, 0, count);
+}
+
+static void bits_align(FlacBits* bw) {
+    if (bw->bits > 0) bits_put(bw, 0, 8 - bw->bits);
+}
+
+// FLAC's UTF-8 style coding of the frame number
+static void bits_put_utf8(FlacBits* bw, unsigned long value) {
+    int extra, i;
+
+    if (value < 0x80) {
+        bits_put(bw, (unsigned int)value, 8);
+        return;
+    }
+    if (value < 0x800) extra = 1;
+    else if (value < 0x10000) extra = 2;
+    else if (value < 0x200000) extra = 3;
+    else if (value < 0x4000000) extra = 4;
+    else extra = 5;
+
+    // Leading byte: extra + 1 one bits, a zero, then the top value bits
+    bits_put(bw, ((1u << (extra + 1)) - 1) << 1, extra + 2);
+    bits_put(bw, (unsigned int)(value >> (6 * extra)), 8 - (extra + 2));
+    for (i = extra - 1; i >= 0; i--) {
+        bits_put(bw, 0x80 | ((value >> (6 * i)) & 0x3f), 8);
+    }
+}
+
+// Fixed predictor residual of the given order
+static void flac_fixed_residual(const int* x, int n, int order, int* r) {
+    int i;
+
+    switch (order) {
+    case 0:
+        for (i = 0; i < n; i++) r[i] = x[i];
+        break;
+    case 1:
+        for (i = 1; i < n; i++) r[i - 1] = x[i] - x[i - 1];
+        break;
+    case 2:
+        for (i = 2; i < n; i++) r[i - 2] = x[i] - 2 * x[i - 1] + x[i - 2];
+        break;
+    case 3:
+        for (i = 3; i < n; i++) r[i - 3] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+        break;
+    default:
+        for (i = 4; i < n; i++) r[i - 4] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+        break;
+    }
+}
+
+static unsigned int flac_zigzag(int v) {
+    return ((unsigned int)v << 1) ^ (unsigned int)(v >> 31);
+}
+
+// Best Rice parameter and its cost in bits for a run of residuals
+static unsigned long long flac_rice_cost(const int* r, int n, int* param) {
+    unsigned long long sum = 0, best = ~0ULL;
+    int i, k, k0 = 0;
+
+    for (i = 0; i < n; i++) sum += flac_zigzag(r[i]);
+    while (k0 < FLAC_MAX_RICE_PARAM && ((unsigned long long)n << (k0 + 1)) < sum) k0++;
+
+    // The estimate is within one of the optimum
+    for (k = (k0 > 0) ? k0 - 1 : 0; k <= k0 + 1 && k <= FLAC_MAX_RICE_PARAM; k++) {
+        unsigned long long bits = (unsigned long long)n * (k + 1);
+        for (i = 0; i < n; i++) bits += flac_zigzag(r[i]) >> k;
+        if (bits < best) {
+            best = bits;
+            *param = k;
+        }
+    }
+    return best;
+}
+
+// Choose the partition order; returns total residual bits
+static unsigned long long flac_partition_cost(const int* r, int block, int order, int* best_order) {
+    unsigned long long best = ~0ULL;
+    int po, p, param;
+
+    for (po = 0; po <= FLAC_MAX_PARTITION_ORDER; po++) {
+        int size = block >> po;
+        unsigned long long bits = 6;    // coding method + partition order
+        const int* run = r;
+
+        if ((block & ((1 << po) - 1)) != 0 || size <= order) break;
+        for (p = 0; p < (1 << po); p++) {
+            int n = (p == 0) ? size - order : size;
+            bits += 4 + flac_rice_cost(run, n, &param);
+            run += n;
+        }
+        if (bits < best) {
+            best = bits;
+            *best_order = po;
+        }
+    }
+    return best;
+}
+
+static void flac_put_residual(FlacBits* bw, const int* r, int block, int order, int partition_order) {
+    int size = block >> partition_order;
+    int p, i, param;
+
+    bits_put(bw, 0, 2);                 // Rice coding, 4-bit parameters
+    bits_put(bw, partition_order, 4);
+    for (p = 0; p < (1 << partition_order); p++) {
+        int n = (p == 0) ? size - order : size;
+        flac_rice_cost(r, n, &param);
+        bits_put(bw, param, 4);
+        for (i = 0; i < n; i++) {
+            unsigned int u = flac_zigzag(r[i]);
+            bits_put_zeros(bw, u >> param);
+            bits_put(bw, 1, 1);
+            bits_put(bw, u, param);
+        }
+        r += n;
+    }
+}
+
+// Encode one channel of a block as CONSTANT, FIXED or VERBATIM
+static void flac_put_subframe(FlacBits* bw, const int* x, int n, int bps, int* residual) {
+    unsigned long long best_bits = (unsigned long long)n * bps;
+    int best_order = -1, best_partition = 0;
+    int order, i;
+
+    for (i = 1; i < n && x[i] == x[0]; i++) {
+    }
+    if (i == n) {
+        bits_put(bw, 0x00, 8);          // CONSTANT
+        bits_put_signed(bw, x[0], bps);
+        return;
+    }
+
+    for (order = 0; order <= FLAC_MAX_FIXED_ORDER && order < n; order++) {
+        unsigned long long bits;
+        int partition = 0;
+
+        flac_fixed_residual(x, n, order, residual);
+        bits = flac_partition_cost(residual, n, order, &partition);
+        if (bits == ~0ULL) break;       // Block too short for this order
+        bits += (unsigned long long)order * bps;
+        if (bits < best_bits) {
+            best_bits = bits;
+            best_order = order;
+            best_partition = partition;
+        }
+    }
+
+    if (best_order < 0) {
+        bits_put(bw, 0x02, 8);          // VERBATIM
+        for (i = 0; i < n; i++) bits_put_signed(bw, x[i], bps);
+        return;
+    }
+
+    bits_put(bw, (0x08 | best_order) << 1, 8);     // FIXED
+    for (i = 0; i < best_order; i++) bits_put_signed(bw, x[i], bps);
+    flac_fixed_residual(x, n, best_order, residual);
+    flac_put_residual(bw, residual, n, best_order, best_partition);
+}
+
+// Encode a slot into its output buffer
+static void flac_encode_slot(IrixAudioCapture* cap, FlacSlot* slot, int* residual) {
+    int channels = cap->params.channels;
+    int bps = cap->params.bits_per_sample;
+    int block = cap->params.block_frames;
+    FlacBits bw;
+    int header_bytes, c;
+    unsigned short crc;
+
+    bits_init(&bw, slot->out);
+
+    // Frame header
+    bits_put(&bw, 0xfff8, 16);          // Sync, fixed block size
+    bits_put(&bw, 0x7, 4);              // 16-bit block size at end of header
+    bits_put(&bw, 0x0, 4);              // Sample rate from STREAMINFO
+    bits_put(&bw, channels - 1, 4);     // Independent channels
+    bits_put(&bw, (bps == 16) ? 0x4 : 0x6, 3);
+    bits_put(&bw, 0, 1);
+    bits_put_utf8(&bw, slot->frame_number);
+    bits_put(&bw, slot->frames - 1, 16);
+    header_bytes = bw.bytes;
+    bits_put(&bw, flac_crc8(slot->out, header_bytes), 8);
+
+    for (c = 0; c < channels; c++) {
+        flac_put_subframe(&bw, slot->samples + c * block, slot->frames, bps, residual);
+    }
+
+    bits_align(&bw);
+    crc = flac_crc16(slot->out, bw.bytes);
+    bits_put(&bw, crc, 16);
+    slot->out_bytes = bw.bytes;
+}
+
+// STREAMINFO metadata block, written at open and rewritten at close
+static int flac_write_header(IrixAudioCapture* cap) {
+    unsigned char header[8 + FLAC_STREAMINFO_SIZE];
+    unsigned long long total = cap->stats.frames_captured;
+    FlacBits bw;
+    int i;
+
+    bits_init(&bw, header);
+    bits_put(&bw, 0x664c6143, 32);      // "fLaC"
+    bits_put(&bw, 0x80, 8);             // Last metadata block, STREAMINFO
+    bits_put(&bw, FLAC_STREAMINFO_SIZE, 24);
+    bits_put(&bw, cap->params.block_frames, 16);
+    bits_put(&bw, cap->params.block_frames, 16);
+    bits_put(&bw, cap->min_frame_bytes, 24);
+    bits_put(&bw, cap->max_frame_bytes, 24);
+    bits_put(&bw, cap->params.sample_rate, 20);
+    bits_put(&bw, cap->params.channels - 1, 3);
+    bits_put(&bw, cap->params.bits_per_sample - 1, 5);
+    bits_put(&bw, (unsigned int)(total >> 32) & 0xf, 4);
+    bits_put(&bw, (unsigned int)total, 32);
+    for (i = 0; i < 4; i++) {
+        bits_put(&bw, 0, 32);           // MD5 not computed
+    }
+
+    if (fseek(cap->file, 0, SEEK_SET) != 0 ||
+        fwrite(header, 1, sizeof(header), cap->file) != sizeof(header)) {
+        return -1;
+    }
+    return 0;
+}
+
+// Write encoded slots in order and hand them back to the capture thread
+static void flac_flush_encoded(IrixAudioCapture* cap) {
+    pthread_mutex_lock(&cap->write_mutex);
+    for (;;) {
+        FlacSlot* slot = &cap->slots[cap->write_index];
+        if (slot->state != SLOT_ENCODED) break;
+
+        if (fwrite(slot->out, 1, slot->out_bytes, cap->file) != (size_t)slot->out_bytes) {
+            cap->stats.write_errors++;
+        }
+        cap->stats.bytes_written += slot->out_bytes;
+        cap->stats.blocks_encoded++;
+        cap->frames_encoded += slot->frames;
+        if (cap->min_frame_bytes == 0 || slot->out_bytes < cap->min_frame_bytes) {
+            cap->min_frame_bytes = slot->out_bytes;
+        }
+        if (slot->out_bytes > cap->max_frame_bytes) cap->max_frame_bytes = slot->out_bytes;
+
+        IRIX_AUDIO_BARRIER();
+        slot->state = SLOT_FREE;
+        if (++cap->write_index == cap->params.queue_blocks) cap->write_index = 0;
+    }
+    pthread_mutex_unlock(&cap->write_mutex);
+}
+
+static void* flac_worker(void* arg) {
+    IrixAudioCapture* cap = (IrixAudioCapture*)arg;
+    int* residual = malloc(cap->params.block_frames * sizeof(int));
+
+    for (;;) {
+        FlacSlot* slot = NULL;
+        int done;
+
+        while (sem_wait(&cap->work_ready) != 0) {
+        }
+        pthread_mutex_lock(&cap->claim_mutex);
+        if (cap->slots[cap->claim_index].state == SLOT_FILLED) {
+            slot = &cap->slots[cap->claim_index];
+            slot->state = SLOT_ENCODING;
+            cap->blocks_claimed++;
+            if (++cap->claim_index == cap->params.queue_blocks) cap->claim_index = 0;
+        }
+        done = cap->closing && cap->blocks_claimed == cap->blocks_published;
+        pthread_mutex_unlock(&cap->claim_mutex);
+
+        if (slot) {
+            IRIX_AUDIO_BARRIER();
+            flac_encode_slot(cap, slot, residual);
+            IRIX_AUDIO_BARRIER();
+            slot->state = SLOT_ENCODED;
+            flac_flush_encoded(cap);
+        } else if (done) {
+            break;
+        }
+    }
+
+    free(residual);
+    return NULL;
+}
+
+// Open a FLAC capture file and start the encoder threads
+IrixAudioCapture* irix_audio_capture_open(IrixAudioCaptureParams* params) {
+    IrixAudioCapture* cap;
+    int i;
+
+    if (!params || !params->path || params->channels <= 0 || params->channels > 8 ||
+        params->sample_rate <= 0 || params->sample_rate >= (1 << 20)) {
+        irix_audio_set_error("Invalid capture parameters");
+        return NULL;
+    }
+    if (params->bits_per_sample != 0 && params->bits_per_sample != 16 &&
+        params->bits_per_sample != 24) {
+        irix_audio_set_error("Capture supports 16 or 24 bits per sample");
+        return NULL;
+    }
+    pthread_once(&flac_tables_once, flac_init_tables);
+
+    cap = calloc(1, sizeof(IrixAudioCapture));
+    if (!cap) {
+        irix_audio_set_error("Cannot allocate capture");
+        return NULL;
+    }
+    cap->params = *params;
+    if (cap->params.bits_per_sample == 0) cap->params.bits_per_sample = 24;
+    if (cap->params.block_frames <= 0) cap->params.block_frames = 4096;
+    if (cap->params.block_frames < 16) cap->params.block_frames = 16;
+    if (cap->params.block_frames > 65535) cap->params.block_frames = 65535;
+    if (cap->params.queue_blocks <= 0) cap->params.queue_blocks = 32;
+    if (cap->params.workers <= 0) cap->params.workers = 2;
+
+    // Worst case is a verbatim frame plus headers
+    cap->out_capacity = cap->params.block_frames * cap->params.channels *
+                        cap->params.bits_per_sample / 8 + cap->params.channels * 8 + 32;
+
+    cap->slots = calloc(cap->params.queue_blocks, sizeof(FlacSlot));
+    if (!cap->slots) {
+        irix_audio_set_error("Cannot allocate capture queue");
+        free(cap);
+        return NULL;
+    }
+    for (i = 0; i < cap->params.queue_blocks; i++) {
+        cap->slots[i].samples = malloc(cap->params.block_frames * cap->params.channels * sizeof(int));
+        cap->slots[i].out = malloc(cap->out_capacity);
+        if (!cap->slots[i].samples || !cap->slots[i].out) {
+            irix_audio_set_error("Cannot allocate capture queue");
+            irix_audio_capture_close(cap);
+            return NULL;
+        }
+    }
+
+    cap->file = fopen(params->path, "wb");
+    if (!cap->file) {
+        irix_audio_set_error("Cannot open capture file: %s", params->path);
+        irix_audio_capture_close(cap);
+        return NULL;
+    }
+    if (flac_write_header(cap) < 0) {
+        irix_audio_set_error("Cannot write capture header: %s", params->path);
+        irix_audio_capture_close(cap);
+        return NULL;
+    }
+    cap->stats.bytes_written = 8 + FLAC_STREAMINFO_SIZE;
+
+    pthread_mutex_init(&cap->claim_mutex, NULL);
+    pthread_mutex_init(&cap->write_mutex, NULL);
+    sem_init(&cap->work_ready, 0, 0);
+    cap->workers = calloc(cap->params.workers, sizeof(pthread_t));
+    if (!cap->workers) {
+        irix_audio_set_error("Cannot allocate capture workers");
+        irix_audio_capture_close(cap);
+        return NULL;
+    }
+    for (i = 0; i < cap->params.workers; i++) {
+        if (pthread_create(&cap->workers[i], NULL, flac_worker, cap) != 0) {
+            irix_audio_set_error("Cannot start capture worker thread");
+            irix_audio_capture_close(cap);
+            return NULL;
+        }
+        cap->worker_count++;
+    }
+
+    return cap;
+}
+
+// Hand the slot being filled to the encoders
+static void flac_publish(IrixAudioCapture* cap) {
+    FlacSlot* slot = &cap->slots[cap->fill_index];
+
+    slot->frames = cap->fill_frames;
+    slot->frame_number = cap->blocks_published;
+    cap->stats.frames_captured += cap->fill_frames;
+    IRIX_AUDIO_BARRIER();
+    slot->state = SLOT_FILLED;
+    cap->blocks_published++;
+    sem_post(&cap->work_ready);
+
+    cap->fill_frames = 0;
+    if (++cap->fill_index == cap->params.queue_blocks) cap->fill_index = 0;
+}
+
+// Queue frames for encoding; never blocks. Frames that find the queue
+// full are dropped and counted.
+int irix_audio_capture_write(IrixAudioCapture* cap, const float* buffer, int frames) {
+    int channels, block, done = 0;
+    float scale, max_value;
+
+    if (!cap || !buffer || frames < 0 || cap->closing) {
+        irix_audio_set_error("Invalid capture");
+        return -1;
+    }
+
+    channels = cap->params.channels;
+    block = cap->params.block_frames;
+    scale = (float)(1 << (cap->params.bits_per_sample - 1));
+    max_value = scale - 1.0f;
+
+    while (done < frames) {
+        FlacSlot* slot = &cap->slots[cap->fill_index];
+        int n = block - cap->fill_frames;
+        int i, c;
+
+        if (n > frames - done) n = frames - done;
+
+        // A block is dropped whole when no slot is free at its start
+        if (cap->fill_frames == 0) cap->dropping = (slot->state != SLOT_FREE);
+        if (cap->dropping) {
+            cap->stats.frames_dropped += n;
+            cap->fill_frames += n;
+            done += n;
+            if (cap->fill_frames == block) cap->fill_frames = 0;
+            continue;
+        }
+
+        // Convert to integers, de-interleaving into channel planes
+        for (c = 0; c < channels; c++) {
+            int* plane = slot->samples + c * block + cap->fill_frames;
+            const float* in = buffer + done * channels + c;
+            for (i = 0; i < n; i++) {
+                float v = in[i * channels] * scale;
+                v = (v >= 0.0f) ? v + 0.5f : v - 0.5f;
+                if (v > max_value) v = max_value;
+                if (v < -scale) v = -scale;
+                plane[i] = (int)v;
+            }
+        }
+        cap->fill_frames += n;
+        done += n;
+
+        if (cap->fill_frames == block) flac_publish(cap);
+    }
+
+    return frames;
+}
+
+// Get capture statistics
+int irix_audio_capture_get_stats(IrixAudioCapture* cap, IrixAudioCaptureStats* stats) {
+    unsigned long long payload;
+
+    if (!cap || !stats) {
+        irix_audio_set_error("Invalid capture");
+        return -1;
+    }
+
+    *stats = cap->stats;
+    payload = cap->stats.bytes_written - (8 + FLAC_STREAMINFO_SIZE);
+    stats->compression_ratio = payload ?
+        (double)(cap->frames_encoded * cap->params.channels *
+                 (cap->params.bits_per_sample / 8)) / payload : 0.0;
+    return 0;
+}
+
+// Flush, stop the workers and complete the file; statistics stay
+// readable until the capture is closed
+int irix_audio_capture_finish(IrixAudioCapture* cap) {
+    int i, result = 0;
+
+    if (!cap) return -1;
+    if (cap->finished) return cap->finish_result;
+    cap->finished = 1;
+
+    if (cap->worker_count > 0) {
+        if (cap->fill_frames > 0 && !cap->dropping) flac_publish(cap);
+        IRIX_AUDIO_BARRIER();
+        cap->closing = 1;
+        for (i = 0; i < cap->worker_count; i++) {
+            sem_post(&cap->work_ready);
+        }
+        for (i = 0; i < cap->worker_count; i++) {
+            pthread_join(cap->workers[i], NULL);
+        }
+        pthread_mutex_destroy(&cap->claim_mutex);
+        pthread_mutex_destroy(&cap->write_mutex);
+        sem_destroy(&cap->work_ready);
+
+        if (cap->stats.write_errors > 0 || flac_write_header(cap) < 0) {
+            irix_audio_set_error("Error writing capture file: %s", cap->params.path);
+            result = -1;
+        }
+    }
+
+    if (cap->file && fclose(cap->file) != 0) result = -1;
+    cap->file = NULL;
+    cap->finish_result = result;
+    return result;
+}
+
+// Finish the file if needed and free the capture
+int irix_audio_capture_close(IrixAudioCapture* cap) {
+    int i, result;
+
+    if (!cap) return -1;
+
+    result = irix_audio_capture_finish(cap);
+    if (cap->slots) {
+        for (i = 0; i < cap->params.queue_blocks; i++) {
+            free(cap->slots[i].samples);
+            free(cap->slots[i].out);
+        }
+        free(cap->slots);
+    }
+    free(cap->workers);
+    free(cap);
+    return result;
+}
+
+// Attach a capture as the sink of an input stream
+int irix_audio_capture_attach(IrixAudioStream* stream, IrixAudioCapture* cap) {
+    if (!stream || stream->mode != IRIX_AUDIO_INPUT) {
+        irix_audio_set_error("Capture requires an input stream");
+        return -1;
+    }
+    if (cap && cap->params.channels != stream->channels) {
+        irix_audio_set_error("Capture does not match stream");
+        return -1;
+    }
+    stream->capture = cap;
+    return 0;
+}
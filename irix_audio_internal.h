@@ -0,0 +1,79 @@
+// IRIX Audio Library - internal declarations
+// Shared between the library modules; not installed with irix_audio.h
+
+#ifndef IRIX_AUDIO_INTERNAL_H
+#define IRIX_AUDIO_INTERNAL_H
+
+#include "irix_audio.h"
+
+// Error handling (irix_audio.c)
+void irix_audio_set_error(const char* format, ...);
+
+// Processing chain staging for the write path (irix_audio_dsp.c)
+int irix_audio_chain_stage(IrixAudioChain* chain, const float* buffer, int frames, float** staged);
+
+// Real FFT (irix_audio_fft.c); bins are size / 2 + 1 split complex values
+typedef struct IrixAudioFft IrixAudioFft;
+IrixAudioFft* irix_audio_fft_create(int size);
+void irix_audio_fft_destroy(IrixAudioFft* fft);
+int irix_audio_fft_size(IrixAudioFft* fft);
+void irix_audio_fft_forward(IrixAudioFft* fft, const float* in, float* re, float* im);
+void irix_audio_fft_inverse(IrixAudioFft* fft, const float* re, const float* im, float* out);
+
+// Gain step from the event queue, audio thread only (irix_audio_dsp.c)
+int irix_audio_chain_apply_gain(IrixAudioChain* chain, int node, double gain_db);
+
+// Event dispatch, audio thread only (irix_audio_events.c)
+// Applies every event due at or before position and returns how many of
+// the next frames can run before the following event.
+int irix_audio_events_run(IrixAudioEvents* events, IrixAudioStream* stream, long long position,
+                          int frames);
+// Frame of the earliest pending event, or -1
+long long irix_audio_events_next(IrixAudioEvents* events);
+
+// Convolver geometry (irix_audio_conv.c)
+int irix_audio_convolver_channels(IrixAudioConvolver* conv);
+
+// I/O trace hooks around each read/write call (irix_audio_trace.c)
+typedef struct {
+    long long start;
+    int fill;
+} IrixAudioTraceMark;
+// Queue fill for the next call when it is due for a sample, else -1
+int irix_audio_trace_fill(IrixAudioTrace* trace);
+void irix_audio_trace_begin(IrixAudioTrace* trace, IrixAudioTraceMark* mark, int fill);
+void irix_audio_trace_end(IrixAudioTrace* trace, IrixAudioTraceMark* mark, int op,
+                          int requested, int transferred);
+// The output queue was emptied deliberately; the next write is not an xrun
+void irix_audio_trace_rearm(IrixAudioTrace* trace);
+// Stream is closing: stop recording, leave the trace for irix_audio_trace_close
+void irix_audio_trace_detach(IrixAudioTrace* trace);
+
+// Real-time guard brackets around AL I/O (irix_audio_rt.c)
+#ifdef IRIX_AUDIO_RT_DEBUG
+void irix_audio_rt_io_begin(void);
+void irix_audio_rt_io_end(void);
+#else
+#define irix_audio_rt_io_begin()
+#define irix_audio_rt_io_end()
+#endif
+
+// Memory barrier for the lock-free queues shared with the audio thread
+#if defined(__GNUC__)
+#define IRIX_AUDIO_BARRIER() __sync_synchronize()
+#elif defined(__sgi)
+#define IRIX_AUDIO_BARRIER() __synchronize()
+#else
+#define IRIX_AUDIO_BARRIER()
+#endif
+
+// Atomic increment for counters bumped from more than one thread
+#if defined(__GNUC__)
+#define IRIX_AUDIO_ATOMIC_INC(p) ((void)__sync_fetch_and_add((p), 1))
+#elif defined(__sgi)
+#define IRIX_AUDIO_ATOMIC_INC(p) ((void)__fetch_and_add((p), 1))
+#else
+#define IRIX_AUDIO_ATOMIC_INC(p) ((void)++*(p))
+#endif
+
+#endif // IRIX_AUDIO_INTERNAL_H
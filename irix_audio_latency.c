@@ -0,0 +1,264 @@
+// IRIX Audio Library - Round-trip latency measurement
+// Plays a band-limited linear sweep through an output stream while
+// reading an input stream in lock step, then cross-correlates the
+// captured signal with the sweep. The lag of the correlation peak is the
+// round trip from writing a frame to reading it back; a parabolic fit
+// around the peak gives the fraction of a frame.
+//
+// Both queues are sampled between each read and the following write. At
+// that point the frame about to be written plays after the output fill,
+// and the input has already captured input-fill frames past the frame
+// about to be read, so the round trip splits exactly into the two fills
+// plus whatever lies outside the queues (converters, cables, room).
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LATENCY_SWEEP_TOP 0.25      // Sweep end, fraction of the sample rate
+#define LATENCY_FADE_FRAMES 64      // Raised-cosine fade at each end of the sweep
+#define LATENCY_PEAK_GUARD 32       // Lags around the peak left out of the SNR
+#define LATENCY_NEWTON_STEPS 3      // Peak refinement iterations
+#define LATENCY_SAMPLE_TRIES 4      // Attempts to read both fills within one device frame
+
+// Linear sweep from 0 to LATENCY_SWEEP_TOP * rate. A flat band well below
+// Nyquist keeps the correlation peak a few frames wide, which the
+// parabolic fit resolves to a small fraction of a frame.
+static void latency_sweep(float* sweep, int frames, double level) {
+    double top = LATENCY_SWEEP_TOP;
+    int i;
+
+    for (i = 0; i < frames; i++) {
+        double phase = M_PI * top * (double)i * i / frames;
+        double fade = 1.0;
+        if (i < LATENCY_FADE_FRAMES) {
+            fade = 0.5 - 0.5 * cos(M_PI * i / LATENCY_FADE_FRAMES);
+        } else if (i >= frames - LATENCY_FADE_FRAMES) {
+            fade = 0.5 - 0.5 * cos(M_PI * (frames - 1 - i) / LATENCY_FADE_FRAMES);
+        }
+        sweep[i] = (float)(level * fade * sin(phase));
+    }
+}
+
+// Newton steps on the band-limited correlation r(t) = sum R[k] e^(2 pi i k t / size)
+// from its spectrum; a parabola through three lags is biased by up to a
+// twentieth of a frame for this peak shape
+static double latency_refine(const float* re, const float* im, int size, double lag) {
+    int bins = size / 2;
+    int iteration, k;
+
+    for (iteration = 0; iteration < LATENCY_NEWTON_STEPS; iteration++) {
+        double d1 = 0.0, d2 = 0.0;
+        for (k = 1; k < bins; k++) {
+            double w = 2.0 * M_PI * k / size;
+            double cs = cos(w * lag), sn = sin(w * lag);
+            d1 -= w * (re[k] * sn + im[k] * cs);
+            d2 -= w * w * (re[k] * cs - im[k] * sn);
+        }
+        if (d2 == 0.0) break;
+        lag -= d1 / d2;
+    }
+    return lag;
+}
+
+// Cross-correlate capture with sweep; returns the peak lag with fraction
+static double latency_correlate(IrixAudioFft* fft, const float* capture, int capture_frames,
+                                const float* sweep, int sweep_frames, int max_lag,
+                                float* work, float* xr, float* xi, float* sr, float* si,
+                                double* snr_db) {
+    int size = irix_audio_fft_size(fft);
+    int bins = size / 2 + 1;
+    int peak = 0, count = 0, k;
+    double noise = 0.0, offset = 0.0;
+
+    memset(work, 0, size * sizeof(float));
+    memcpy(work, capture, capture_frames * sizeof(float));
+    irix_audio_fft_forward(fft, work, xr, xi);
+
+    memset(work, 0, size * sizeof(float));
+    memcpy(work, sweep, sweep_frames * sizeof(float));
+    irix_audio_fft_forward(fft, work, sr, si);
+
+    // X * conj(S)
+    for (k = 0; k < bins; k++) {
+        float re = xr[k] * sr[k] + xi[k] * si[k];
+        float im = xi[k] * sr[k] - xr[k] * si[k];
+        xr[k] = re;
+        xi[k] = im;
+    }
+    irix_audio_fft_inverse(fft, xr, xi, work);
+
+    for (k = 1; k <= max_lag; k++) {
+        if (fabsf(work[k]) > fabsf(work[peak])) peak = k;
+    }
+    if (peak > 0 && peak < max_lag) {
+        double a = work[peak - 1], b = work[peak], c = work[peak + 1];
+        double denom = a - 2.0 * b + c;
+        if (denom != 0.0) offset = 0.5 * (a - c) / denom;
+        offset = latency_refine(xr, xi, size, peak + offset) - peak;
+        if (offset < -1.0 || offset > 1.0) offset = 0.0;
+    }
+
+    for (k = 0; k <= max_lag; k++) {
+        if (abs(k - peak) < LATENCY_PEAK_GUARD) continue;
+        noise += (double)work[k] * work[k];
+        count++;
+    }
+    noise = (count > 0) ? sqrt(noise / count) : 0.0;
+    *snr_db = (noise > 0.0) ? 20.0 * log10(fabs(work[peak]) / noise) : 0.0;
+
+    return peak + offset;
+}
+
+// Play the sweep once and capture the input. Returns 1 if the queue
+// fills show the round trip moved (an xrun) during the capture.
+static int latency_capture(IrixAudioStream* output, IrixAudioStream* input, IrixAudioLatencyParams* p,
+                           const float* sweep, float* capture, int capture_frames,
+                           float* out, float* in, double* output_frames, double* input_frames) {
+    int iterations = (capture_frames + p->period_frames - 1) / p->period_frames;
+    int sum_min = 0, sum_max = 0;
+    double output_sum = 0.0, input_sum = 0.0;
+    int i, n, c;
+
+    for (i = 0; i < p->settle_frames; i += p->period_frames) {
+        memset(out, 0, p->period_frames * output->channels * sizeof(float));
+        if (irix_audio_write_frames(output, out, p->period_frames) < 0 ||
+            irix_audio_read_frames(input, in, p->period_frames) < 0) return -1;
+    }
+
+    for (i = 0; i < iterations; i++) {
+        int base = i * p->period_frames;
+        int output_fill, input_fill, tries;
+
+        // Read the output fill on both sides of the input fill so a device
+        // frame passing between the calls is not mistaken for an xrun
+        for (tries = 0; tries < LATENCY_SAMPLE_TRIES; tries++) {
+            output_fill = irix_audio_get_filled(output);
+            input_fill = irix_audio_get_filled(input);
+            if (output_fill < 0 || input_fill < 0) return -1;
+            if (irix_audio_get_filled(output) == output_fill) break;
+        }
+
+        // Without xruns the sum of the fills stays constant
+        if (i == 0 || output_fill + input_fill < sum_min) sum_min = output_fill + input_fill;
+        if (i == 0 || output_fill + input_fill > sum_max) sum_max = output_fill + input_fill;
+        output_sum += output_fill;
+        input_sum += input_fill;
+
+        for (n = 0; n < p->period_frames; n++) {
+            float v = (base + n < p->signal_frames) ? sweep[base + n] : 0.0f;
+            for (c = 0; c < output->channels; c++) out[n * output->channels + c] = v;
+        }
+        if (irix_audio_write_frames(output, out, p->period_frames) < 0 ||
+            irix_audio_read_frames(input, in, p->period_frames) < 0) return -1;
+
+        for (n = 0; n < p->period_frames && base + n < capture_frames; n++) {
+            capture[base + n] = in[n * input->channels + p->input_channel];
+        }
+    }
+
+    *output_frames = output_sum / iterations;
+    *input_frames = input_sum / iterations;
+    return (sum_max - sum_min > p->xrun_frames) ? 1 : 0;
+}
+
+// Measure the round trip from output to input
+int irix_audio_measure_latency(IrixAudioStream* output, IrixAudioStream* input,
+                               IrixAudioLatencyParams* params, IrixAudioLatencyResult* result) {
+    IrixAudioLatencyParams p;
+    IrixAudioFft* fft = NULL;
+    float *out = NULL, *in = NULL, *sweep = NULL, *capture = NULL;
+    float *work = NULL, *xr = NULL, *xi = NULL, *sr = NULL, *si = NULL;
+    int capture_frames, fft_size, attempt, n;
+    int status = -1;
+
+    if (!output || !input || output->mode != IRIX_AUDIO_OUTPUT || input->mode != IRIX_AUDIO_INPUT ||
+        !result) {
+        irix_audio_set_error("Latency measurement needs an output and an input stream");
+        return -1;
+    }
+    if (output->sample_rate != input->sample_rate) {
+        irix_audio_set_error("Latency measurement needs matching sample rates");
+        return -1;
+    }
+
+    memset(&p, 0, sizeof(p));
+    if (params) p = *params;
+    if (p.period_frames <= 0) p.period_frames = (output->buffer_size > 0) ? output->buffer_size : 256;
+    if (p.signal_frames <= 0) p.signal_frames = 16384;
+    if (p.max_latency_frames <= 0) p.max_latency_frames = output->sample_rate;
+    if (p.settle_frames <= 0) p.settle_frames = output->sample_rate / 4;
+    if (p.attempts <= 0) p.attempts = 3;
+    if (p.xrun_frames <= 0) p.xrun_frames = 1;
+    if (p.level <= 0.0) p.level = 0.5;
+    if (p.input_channel < 0 || p.input_channel >= input->channels) {
+        irix_audio_set_error("Invalid input channel: %d", p.input_channel);
+        return -1;
+    }
+    if (p.signal_frames < 4 * LATENCY_FADE_FRAMES) p.signal_frames = 4 * LATENCY_FADE_FRAMES;
+
+    capture_frames = p.signal_frames + p.max_latency_frames + 1;
+    fft_size = 4;
+    while (fft_size < capture_frames + p.signal_frames) fft_size <<= 1;
+
+    fft = irix_audio_fft_create(fft_size);
+    out = malloc(p.period_frames * output->channels * sizeof(float));
+    in = malloc(p.period_frames * input->channels * sizeof(float));
+    sweep = malloc(p.signal_frames * sizeof(float));
+    capture = calloc(capture_frames, sizeof(float));
+    work = malloc(fft_size * sizeof(float));
+    xr = malloc((fft_size / 2 + 1) * sizeof(float));
+    xi = malloc((fft_size / 2 + 1) * sizeof(float));
+    sr = malloc((fft_size / 2 + 1) * sizeof(float));
+    si = malloc((fft_size / 2 + 1) * sizeof(float));
+    if (!fft || !out || !in || !sweep || !capture || !work || !xr || !xi || !sr || !si) {
+        if (fft) irix_audio_set_error("Cannot allocate latency measurement");
+        goto done;
+    }
+    latency_sweep(sweep, p.signal_frames, p.level);
+
+    // Drop stale input and prime one period of output
+    n = irix_audio_get_filled(input);
+    while (n >= p.period_frames) {
+        if (irix_audio_read_frames(input, in, p.period_frames) < 0) goto done;
+        n -= p.period_frames;
+    }
+    memset(out, 0, p.period_frames * output->channels * sizeof(float));
+    if (irix_audio_write_frames(output, out, p.period_frames) < 0) goto done;
+
+    // Repeat the capture while xruns move the round trip under it
+    result->restarts = 0;
+    for (attempt = 0; attempt < p.attempts; attempt++) {
+        int moved = latency_capture(output, input, &p, sweep, capture, capture_frames, out, in,
+                                    &result->output_frames, &result->input_frames);
+        if (moved < 0) goto done;
+        if (!moved) break;
+        result->restarts++;
+    }
+    if (attempt == p.attempts) {
+        irix_audio_set_error("Round trip changed during each of %d attempts (xruns)", p.attempts);
+        goto done;
+    }
+
+    result->round_trip_frames = latency_correlate(fft, capture, capture_frames, sweep, p.signal_frames,
+                                                  p.max_latency_frames, work, xr, xi, sr, si,
+                                                  &result->snr_db);
+    result->external_frames = result->round_trip_frames - result->output_frames - result->input_frames;
+    result->sample_rate = output->sample_rate;
+    status = 0;
+
+done:
+    irix_audio_fft_destroy(fft);
+    free(out);
+    free(in);
+    free(sweep);
+    free(capture);
+    free(work);
+    free(xr);
+    free(xi);
+    free(sr);
+    free(si);
+    return status;
+}
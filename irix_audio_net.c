@@ -0,0 +1,636 @@
+// IRIX Audio Library - Network transport
+// RTP-style UDP audio packets with an adaptive jitter buffer
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NET_HEADER_SIZE 12          // RTP fixed header
+#define NET_PAYLOAD_TYPE 96         // Dynamic payload type
+#define NET_MIN_SLOTS 4             // Power of two
+#define NET_CALM_PACKETS 64         // Clean packets before latency is trimmed
+#define NET_CONCEAL_PACKETS 4       // Concealment fades to silence over this many packets
+#define NET_JITTER_MARGIN 3.0       // Target latency in multiples of the jitter estimate
+
+// Jitter buffer slot
+typedef struct {
+    int valid;
+    unsigned short seq;
+    double ready_time;          // Local clock (frames) at which the packet is playable
+    float* samples;
+} NetSlot;
+
+struct IrixAudioNet {
+    IrixAudioNetParams params;
+    int socket_fd;
+    struct sockaddr_in remote;
+    unsigned char* packet;      // Wire buffer
+    int packet_bytes;
+    int frame_samples;          // packet_frames * channels
+
+    // Sender state
+    unsigned short send_seq;
+    unsigned int send_timestamp;
+    unsigned int ssrc;
+    float* staging;
+    int staged;
+
+    // Receiver state
+    NetSlot* slots;
+    int slot_count;
+    int have_base;              // play_seq holds a valid sequence number
+    int playing;
+    unsigned short play_seq;    // Next packet to load
+    int have_newest;
+    unsigned short newest_seq;
+    float* current;             // Packet being played out
+    int play_offset;            // Frames of current already played
+    float* last_good;           // Last real packet, source for concealment
+    int have_last_good;
+    int conceal_run;
+    int have_transit;
+    double last_transit;
+    int calm_count;
+    unsigned int rng;
+    float* scratch;             // Pump buffer
+
+    IrixAudioNetStats stats;
+};
+
+// Local clock in frames
+static double net_now(IrixAudioNet* net) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return ((double)tv.tv_sec + (double)tv.tv_usec * 1e-6) * net->params.sample_rate;
+}
+
+// Small LCG for the loss/jitter simulation, uniform in [0, 1)
+static double net_random(IrixAudioNet* net) {
+    net->rng = net->rng * 1103515245u + 12345u;
+    return (double)((net->rng >> 8) & 0xffffff) / 16777216.0;
+}
+
+// Signed distance between two 16-bit sequence numbers
+static int net_seq_diff(unsigned short a, unsigned short b) {
+    return (short)(unsigned short)(a - b);
+}
+
+static void net_put32(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static unsigned int net_get32(const unsigned char* p) {
+    return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) |
+           ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+// Resolve a dotted address or host name
+static int net_resolve(const char* host, struct in_addr* addr) {
+    struct hostent* entry;
+
+    if (!host) {
+        addr->s_addr = htonl(INADDR_ANY);
+        return 0;
+    }
+    addr->s_addr = inet_addr(host);
+    if (addr->s_addr != (in_addr_t)-1) return 0;
+
+    entry = gethostbyname(host);
+    if (!entry || entry->h_addrtype != AF_INET) return -1;
+    memcpy(addr, entry->h_addr_list[0], sizeof(struct in_addr));
+    return 0;
+}
+
+// Open a network transport
+IrixAudioNet* irix_audio_net_open(IrixAudioNetParams* params) {
+    IrixAudioNet* net;
+    struct sockaddr_in local;
+    int i;
+
+    if (!params || params->channels <= 0 || params->sample_rate <= 0 || params->port <= 0) {
+        irix_audio_set_error("Invalid network parameters");
+        return NULL;
+    }
+    if (params->direction == IRIX_AUDIO_NET_SEND && !params->host) {
+        irix_audio_set_error("Network sender requires a host");
+        return NULL;
+    }
+
+    net = calloc(1, sizeof(IrixAudioNet));
+    if (!net) {
+        irix_audio_set_error("Cannot allocate network transport");
+        return NULL;
+    }
+    net->params = *params;
+    if (net->params.packet_frames <= 0) net->params.packet_frames = 256;
+    if (net->params.max_latency_frames <= 0) net->params.max_latency_frames = net->params.sample_rate / 2;
+
+    net->frame_samples = net->params.packet_frames * net->params.channels;
+    net->packet_bytes = NET_HEADER_SIZE + net->frame_samples * 4;
+    // A power of two divides the 16-bit sequence space, so slots stay
+    // consecutive across the wrap from 65535 to 0
+    net->slot_count = NET_MIN_SLOTS;
+    while (net->slot_count * net->params.packet_frames < net->params.max_latency_frames) {
+        net->slot_count <<= 1;
+    }
+    net->rng = (unsigned int)getpid() ^ (unsigned int)params->port;
+    net->ssrc = net->rng * 2654435761u;
+    net->socket_fd = -1;
+
+    net->packet = malloc(net->packet_bytes);
+    net->staging = malloc(net->frame_samples * sizeof(float));
+    net->current = malloc(net->frame_samples * sizeof(float));
+    net->last_good = calloc(net->frame_samples, sizeof(float));
+    net->scratch = malloc(net->frame_samples * sizeof(float));
+    net->slots = calloc(net->slot_count, sizeof(NetSlot));
+    if (!net->packet || !net->staging || !net->current || !net->last_good ||
+        !net->scratch || !net->slots) {
+        irix_audio_set_error("Cannot allocate network buffers");
+        irix_audio_net_close(net);
+        return NULL;
+    }
+    for (i = 0; i < net->slot_count; i++) {
+        net->slots[i].samples = malloc(net->frame_samples * sizeof(float));
+        if (!net->slots[i].samples) {
+            irix_audio_set_error("Cannot allocate jitter buffer");
+            irix_audio_net_close(net);
+            return NULL;
+        }
+    }
+    net->play_offset = net->params.packet_frames;
+    net->stats.target_latency_frames = 2 * net->params.packet_frames;
+
+    // Open the socket
+    net->socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (net->socket_fd < 0) {
+        irix_audio_set_error("Cannot create socket: %s", strerror(errno));
+        irix_audio_net_close(net);
+        return NULL;
+    }
+
+    if (params->direction == IRIX_AUDIO_NET_SEND) {
+        memset(&net->remote, 0, sizeof(net->remote));
+        net->remote.sin_family = AF_INET;
+        net->remote.sin_port = htons((unsigned short)params->port);
+        if (net_resolve(params->host, &net->remote.sin_addr) < 0) {
+            irix_audio_set_error("Cannot resolve host: %s", params->host);
+            irix_audio_net_close(net);
+            return NULL;
+        }
+    } else {
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons((unsigned short)params->port);
+        if (net_resolve(params->host, &local.sin_addr) < 0) {
+            irix_audio_set_error("Cannot resolve bind address: %s", params->host);
+            irix_audio_net_close(net);
+            return NULL;
+        }
+        if (bind(net->socket_fd, (struct sockaddr*)&local, sizeof(local)) < 0) {
+            irix_audio_set_error("Cannot bind port %d: %s", params->port, strerror(errno));
+            irix_audio_net_close(net);
+            return NULL;
+        }
+        // The receive path polls; it must never block the audio thread
+        fcntl(net->socket_fd, F_SETFL, fcntl(net->socket_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    return net;
+}
+
+// Close a network transport
+void irix_audio_net_close(IrixAudioNet* net) {
+    int i;
+
+    if (!net) return;
+
+    if (net->socket_fd >= 0) close(net->socket_fd);
+    if (net->slots) {
+        for (i = 0; i < net->slot_count; i++) {
+            free(net->slots[i].samples);
+        }
+        free(net->slots);
+    }
+    free(net->packet);
+    free(net->staging);
+    free(net->current);
+    free(net->last_good);
+    free(net->scratch);
+    free(net);
+}
+
+// Send one full packet from the staging buffer
+static int net_send_packet(IrixAudioNet* net) {
+    unsigned char* p = net->packet;
+    unsigned int bits;
+    int i;
+
+    p[0] = 0x80;                // Version 2, no padding/extension/CSRC
+    p[1] = NET_PAYLOAD_TYPE;
+    p[2] = (unsigned char)(net->send_seq >> 8);
+    p[3] = (unsigned char)net->send_seq;
+    net_put32(p + 4, net->send_timestamp);
+    net_put32(p + 8, net->ssrc);
+
+    p += NET_HEADER_SIZE;
+    for (i = 0; i < net->frame_samples; i++) {
+        memcpy(&bits, &net->staging[i], 4);
+        net_put32(p + i * 4, bits);
+    }
+
+    if (sendto(net->socket_fd, net->packet, net->packet_bytes, 0,
+               (struct sockaddr*)&net->remote, sizeof(net->remote)) < 0) {
+        irix_audio_set_error("Error sending packet: %s", strerror(errno));
+        return -1;
+    }
+
+    net->send_seq++;
+    net->send_timestamp += net->params.packet_frames;
+    net->stats.packets_sent++;
+    return 0;
+}
+
+// Send frames; partial packets are held until the next call
+int irix_audio_net_send(IrixAudioNet* net, const float* buffer, int frames) {
+    int channels, sent = 0;
+
+    if (!net || net->params.direction != IRIX_AUDIO_NET_SEND || !buffer || frames < 0) {
+        irix_audio_set_error("Invalid network sender");
+        return -1;
+    }
+
+    channels = net->params.channels;
+    while (sent < frames) {
+        int n = net->params.packet_frames - net->staged;
+        if (n > frames - sent) n = frames - sent;
+
+        memcpy(net->staging + net->staged * channels, buffer + sent * channels,
+               n * channels * sizeof(float));
+        net->staged += n;
+        sent += n;
+
+        if (net->staged == net->params.packet_frames) {
+            net->staged = 0;
+            if (net_send_packet(net) < 0) return -1;
+        }
+    }
+
+    return sent;
+}
+
+// Frames queued ahead of the playout point
+static int net_latency(IrixAudioNet* net) {
+    int pf = net->params.packet_frames;
+    int ahead;
+
+    if (!net->have_base || !net->have_newest) return 0;
+
+    ahead = net_seq_diff(net->newest_seq, net->play_seq) + 1;
+    if (ahead < 0) ahead = 0;
+    if (!net->playing) return ahead * pf;
+    return (pf - net->play_offset) + ahead * pf;
+}
+
+// Lowest latency the current jitter estimate allows
+static int net_latency_floor(IrixAudioNet* net) {
+    int pf = net->params.packet_frames;
+    int floor = pf + (int)ceil(NET_JITTER_MARGIN * net->stats.jitter_frames);
+
+    // Round up to whole packets
+    return ((floor + pf - 1) / pf) * pf;
+}
+
+// Forget all buffered packets and pre-roll again
+static void net_resync(IrixAudioNet* net) {
+    int i;
+
+    for (i = 0; i < net->slot_count; i++) {
+        net->slots[i].valid = 0;
+    }
+    net->have_base = 0;
+    net->have_newest = 0;
+    net->playing = 0;
+    net->play_offset = net->params.packet_frames;
+}
+
+// Store a received packet in the jitter buffer
+static void net_store_packet(IrixAudioNet* net, const unsigned char* p, int length) {
+    unsigned short seq;
+    unsigned int timestamp, bits;
+    double arrival, transit;
+    NetSlot* slot;
+    int i, diff;
+
+    if (length != net->packet_bytes || (p[0] & 0xc0) != 0x80 ||
+        (p[1] & 0x7f) != NET_PAYLOAD_TYPE) {
+        return;
+    }
+    seq = (unsigned short)((p[2] << 8) | p[3]);
+    timestamp = net_get32(p + 4);
+
+    // Simulated network impairment
+    if (net->params.loss_rate > 0.0 && net_random(net) < net->params.loss_rate) return;
+    arrival = net_now(net);
+    if (net->params.jitter_frames > 0) arrival += net_random(net) * net->params.jitter_frames;
+
+    net->stats.packets_received++;
+
+    // Interarrival jitter (RFC 3550, section 6.4.1)
+    transit = arrival - (double)timestamp;
+    if (net->have_transit) {
+        net->stats.jitter_frames += (fabs(transit - net->last_transit) - net->stats.jitter_frames) / 16.0;
+    }
+    net->last_transit = transit;
+    net->have_transit = 1;
+
+    if (!net->have_base) {
+        net->play_seq = seq;
+        net->have_base = 1;
+    }
+
+    diff = net_seq_diff(seq, net->play_seq);
+    if (diff < 0) {
+        if (net->playing) {
+            net->stats.packets_late++;
+            return;
+        }
+        // Earlier packet during pre-roll becomes the new start
+        net->play_seq = seq;
+        diff = 0;
+    }
+    if (diff >= net->slot_count) {
+        // Sender jumped beyond the buffer (restart or long outage)
+        net_resync(net);
+        net->play_seq = seq;
+        net->have_base = 1;
+    }
+
+    slot = &net->slots[seq & (net->slot_count - 1)];
+    slot->valid = 1;
+    slot->seq = seq;
+    slot->ready_time = arrival;
+    p += NET_HEADER_SIZE;
+    for (i = 0; i < net->frame_samples; i++) {
+        bits = net_get32(p + i * 4);
+        memcpy(&slot->samples[i], &bits, 4);
+    }
+
+    if (!net->have_newest || net_seq_diff(seq, net->newest_seq) > 0) {
+        net->newest_seq = seq;
+        net->have_newest = 1;
+    }
+}
+
+// Drain the socket into the jitter buffer
+static void net_poll(IrixAudioNet* net) {
+    int length;
+
+    for (;;) {
+        length = recvfrom(net->socket_fd, net->packet, net->packet_bytes, 0, NULL, NULL);
+        if (length < 0) break;
+        net_store_packet(net, net->packet, length);
+    }
+}
+
+// Fill current with a faded repeat of the last good packet
+static void net_conceal(IrixAudioNet* net) {
+    int pf = net->params.packet_frames;
+    int channels = net->params.channels;
+    double start, end;
+    int i, c;
+
+    net->conceal_run++;
+    start = 1.0 - (double)(net->conceal_run - 1) / NET_CONCEAL_PACKETS;
+    end = 1.0 - (double)net->conceal_run / NET_CONCEAL_PACKETS;
+    if (start < 0.0) start = 0.0;
+    if (end < 0.0) end = 0.0;
+
+    if (!net->have_last_good || start == 0.0) {
+        memset(net->current, 0, net->frame_samples * sizeof(float));
+    } else {
+        for (i = 0; i < pf; i++) {
+            float gain = (float)(start + (end - start) * i / pf);
+            for (c = 0; c < channels; c++) {
+                net->current[i * channels + c] = net->last_good[i * channels + c] * gain;
+            }
+        }
+    }
+
+    net->stats.frames_concealed += pf;
+    net->calm_count = 0;
+}
+
+// Slot holding packet seq if it is here and playable, else NULL
+static NetSlot* net_ready_slot(IrixAudioNet* net, unsigned short seq, double now) {
+    NetSlot* slot = &net->slots[seq & (net->slot_count - 1)];
+
+    if (!slot->valid || slot->seq != seq || slot->ready_time > now) return NULL;
+    return slot;
+}
+
+// Crossfade over one packet: starts as from, ends as to. out may be from.
+static void net_crossfade(IrixAudioNet* net, float* out, const float* from, const float* to) {
+    int pf = net->params.packet_frames;
+    int channels = net->params.channels;
+    int i, c;
+
+    for (i = 0; i < pf; i++) {
+        float gain = (float)(i + 1) / pf;
+        for (c = 0; c < channels; c++) {
+            int k = i * channels + c;
+            out[k] = from[k] + (to[k] - from[k]) * gain;
+        }
+    }
+}
+
+// Trim or relax the target latency after each real packet
+static void net_adapt(IrixAudioNet* net, double now) {
+    int pf = net->params.packet_frames;
+    int floor = net_latency_floor(net);
+    NetSlot* slot;
+
+    if (net->stats.target_latency_frames < floor) net->stats.target_latency_frames = floor;
+
+    if (++net->calm_count < NET_CALM_PACKETS) return;
+    net->calm_count = 0;
+
+    // Calm network: lower the target toward the jitter floor, keeping a
+    // packet of headroom so a wobbling jitter estimate does not trim and
+    // raise the target (a skip and an insert) over and over
+    if (net->stats.target_latency_frames - pf > floor) net->stats.target_latency_frames -= pf;
+
+    // Skip one packet when we hold more than a packet above target. The
+    // packet in current is merged with the next one: it starts where the
+    // last one left off and ends where the one after the skip begins.
+    if (net_latency(net) > net->stats.target_latency_frames + pf) {
+        slot = net_ready_slot(net, net->play_seq, now);
+        if (!slot) return;
+        net_crossfade(net, net->current, net->current, slot->samples);
+        memcpy(net->last_good, slot->samples, net->frame_samples * sizeof(float));
+        slot->valid = 0;
+        net->play_seq++;
+        net->stats.packets_skipped++;
+    }
+}
+
+// Load the next packet (or its concealment) into current
+static void net_load_packet(IrixAudioNet* net, double now) {
+    NetSlot* slot = &net->slots[net->play_seq & (net->slot_count - 1)];
+    int max_target = net->slot_count * net->params.packet_frames - net->params.packet_frames;
+    // current is used up, so this is what stays queued behind the next packet
+    int behind = net_latency(net) - net->params.packet_frames;
+
+    if (max_target > net->params.max_latency_frames) max_target = net->params.max_latency_frames;
+    net->play_offset = 0;
+
+    // Below target: play one extra packet to let the buffer grow. It starts
+    // like the next packet (which followed the last one) and ends like the
+    // last one (which the next packet follows), so both splices are smooth.
+    if (net->playing && net->have_last_good && net->conceal_run == 0 &&
+        behind < net->stats.target_latency_frames && net_ready_slot(net, net->play_seq, now)) {
+        net_crossfade(net, net->current, slot->samples, net->last_good);
+        net->stats.packets_inserted++;
+        net->calm_count = 0;
+        return;
+    }
+
+    if (slot->valid && slot->seq == net->play_seq && slot->ready_time <= now) {
+        memcpy(net->current, slot->samples, net->frame_samples * sizeof(float));
+        memcpy(net->last_good, slot->samples, net->frame_samples * sizeof(float));
+        net->have_last_good = 1;
+        net->conceal_run = 0;
+        slot->valid = 0;
+        net->play_seq++;
+        net_adapt(net, now);
+        return;
+    }
+
+    if (net->have_newest && net_seq_diff(net->newest_seq, net->play_seq) > 0) {
+        // A later packet is here, so this one is late (in its slot but not
+        // yet due) or lost (never arrived)
+        if (slot->valid && slot->seq == net->play_seq) {
+            slot->valid = 0;
+            net->stats.packets_late++;
+        } else {
+            net->stats.packets_lost++;
+        }
+        net->play_seq++;
+    } else {
+        // Nothing left to play: stretch latency by one packet
+        net->stats.underruns++;
+        net->stats.target_latency_frames += net->params.packet_frames;
+        if (net->stats.target_latency_frames > max_target) net->stats.target_latency_frames = max_target;
+    }
+    net_conceal(net);
+}
+
+// Receive frames; always returns frames, concealing gaps
+int irix_audio_net_receive(IrixAudioNet* net, float* buffer, int frames) {
+    int channels, pf, done = 0;
+    double now;
+
+    if (!net || net->params.direction != IRIX_AUDIO_NET_RECEIVE || !buffer || frames < 0) {
+        irix_audio_set_error("Invalid network receiver");
+        return -1;
+    }
+
+    channels = net->params.channels;
+    pf = net->params.packet_frames;
+    net_poll(net);
+    now = net_now(net);
+
+    // Pre-roll until the target latency is buffered behind the first packet
+    if (!net->playing) {
+        if (net_latency(net) < net->stats.target_latency_frames + pf) {
+            memset(buffer, 0, frames * channels * sizeof(float));
+            net->stats.current_latency_frames = net_latency(net);
+            return frames;
+        }
+        net->playing = 1;
+        net->play_offset = pf;
+    }
+
+    while (done < frames) {
+        int n;
+
+        if (net->play_offset == pf) net_load_packet(net, now);
+
+        n = pf - net->play_offset;
+        if (n > frames - done) n = frames - done;
+        memcpy(buffer + done * channels, net->current + net->play_offset * channels,
+               n * channels * sizeof(float));
+        net->play_offset += n;
+        done += n;
+    }
+
+    net->stats.current_latency_frames = net_latency(net);
+    return done;
+}
+
+// Get transport statistics
+int irix_audio_net_get_stats(IrixAudioNet* net, IrixAudioNetStats* stats) {
+    if (!net || !stats) {
+        irix_audio_set_error("Invalid network transport");
+        return -1;
+    }
+    *stats = net->stats;
+    return 0;
+}
+
+// Attach a transport as the sink of an input stream or the source of an output stream
+int irix_audio_net_attach(IrixAudioStream* stream, IrixAudioNet* net) {
+    if (!stream) {
+        irix_audio_set_error("Invalid stream");
+        return -1;
+    }
+    if (net) {
+        IrixAudioNetDirection wanted = (stream->mode == IRIX_AUDIO_OUTPUT) ?
+                                       IRIX_AUDIO_NET_RECEIVE : IRIX_AUDIO_NET_SEND;
+        if (net->params.direction != wanted || net->params.channels != stream->channels) {
+            irix_audio_set_error("Network transport does not match stream");
+            return -1;
+        }
+    }
+    stream->net = net;
+    return 0;
+}
+
+// Move frames from the attached network source to an output stream
+int irix_audio_net_pump(IrixAudioStream* stream, int frames) {
+    IrixAudioNet* net;
+    int done = 0;
+
+    if (!stream || stream->mode != IRIX_AUDIO_OUTPUT || !stream->net) {
+        irix_audio_set_error("No network source attached to output stream");
+        return -1;
+    }
+
+    net = stream->net;
+    while (done < frames) {
+        int n = net->params.packet_frames;
+        int written;
+
+        if (n > frames - done) n = frames - done;
+        irix_audio_net_receive(net, net->scratch, n);
+        written = irix_audio_write_frames(stream, net->scratch, n);
+        if (written < 0) return -1;
+        done += written;
+    }
+
+    return done;
+}
@@ -0,0 +1,301 @@
+// IRIX Audio Library - Pull-model output with idle suspension
+// The engine asks the application for one period at a time and writes it
+// to an output stream. Each rendered period is checked against a silence
+// threshold; after a run of silent periods the engine goes idle. It stops
+// calling back, and keeps the port alive by topping it up with silence
+// (alZeroFrames) or by letting it drain. irix_audio_render_wake, or an
+// attached event falling due, brings the callback back on the next period,
+// or at once if the engine is waiting. Periods are split at event frames so
+// the callback renders each piece with the events before it applied.
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RENDER_IDLE_SLICES 4        // Wake polls per idle period
+
+struct IrixAudioRender {
+    IrixAudioStream* stream;
+    IrixAudioRenderCallback callback;
+    void* user;
+    IrixAudioRenderParams params;
+    float threshold;
+    float* buffer;
+    long long period_ns;
+
+    int idle;
+    int silent_run;                 // Consecutive silent periods
+    volatile unsigned int wake_count;   // Bumped by irix_audio_render_wake
+    unsigned int wake_seen;
+
+    IrixAudioRenderStats stats;
+};
+
+static long long render_now(void) {
+    struct timespec ts;
+
+#ifdef __sgi
+    clock_gettime(CLOCK_SGI_CYCLE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Peak test over a whole period. Four independent running maxima over
+// blocks of 64 samples keep the FPU pipeline full (the loop vectorizes
+// where the target has packed floats), with one branch per block so a
+// loud period is rejected early.
+static int render_silent(const float* buffer, int samples, float threshold) {
+    int i = 0, j;
+
+    while (i + 64 <= samples) {
+        float m0 = 0.0f, m1 = 0.0f, m2 = 0.0f, m3 = 0.0f;
+        for (j = 0; j < 64; j += 4) {
+            float a0 = fabsf(buffer[i + j]), a1 = fabsf(buffer[i + j + 1]);
+            float a2 = fabsf(buffer[i + j + 2]), a3 = fabsf(buffer[i + j + 3]);
+            m0 = (a0 > m0) ? a0 : m0;
+            m1 = (a1 > m1) ? a1 : m1;
+            m2 = (a2 > m2) ? a2 : m2;
+            m3 = (a3 > m3) ? a3 : m3;
+        }
+        if (m0 > threshold || m1 > threshold || m2 > threshold || m3 > threshold) return 0;
+        i += 64;
+    }
+    for (; i < samples; i++) {
+        if (fabsf(buffer[i]) > threshold) return 0;
+    }
+    return 1;
+}
+
+// Queue silence up to the idle fill
+static int render_zero_fill(IrixAudioRender* render) {
+    IrixAudioStream* stream = render->stream;
+    IrixAudioTraceMark mark;
+    int fill = alGetFilled(stream->port);
+    int missing, result;
+
+    if (fill < 0) {
+        irix_audio_set_error("Error reading queue fill: %s", alGetErrorString(oserror()));
+        return -1;
+    }
+    missing = render->params.idle_fill_frames - fill;
+    if (missing <= 0) return 0;
+
+    // The fill is already at hand; no extra alGetFilled for the trace
+    if (stream->trace) irix_audio_trace_begin(stream->trace, &mark, fill);
+    irix_audio_rt_io_begin();
+    result = alZeroFrames(stream->port, missing);
+    irix_audio_rt_io_end();
+    if (result < 0) {
+        irix_audio_set_error("Error writing silence: %s", alGetErrorString(oserror()));
+    } else {
+        stream->position += missing;
+    }
+    if (stream->trace) {
+        irix_audio_trace_end(stream->trace, &mark, IRIX_AUDIO_TRACE_ZERO, missing,
+                             result < 0 ? -1 : missing);
+    }
+    return (result < 0) ? -1 : 0;
+}
+
+// Leave idle: the source is active again
+static void render_resume(IrixAudioRender* render) {
+    render->silent_run = 0;
+    if (render->idle) {
+        render->idle = 0;
+        render->stats.wakes++;
+        // A drained queue runs empty on purpose; the next write is not an xrun
+        if (render->params.idle_mode == IRIX_AUDIO_IDLE_DRAIN && render->stream->trace) {
+            irix_audio_trace_rearm(render->stream->trace);
+        }
+    }
+}
+
+// Take a pending wake
+static int render_take_wake(IrixAudioRender* render) {
+    unsigned int count = render->wake_count;
+
+    if (count == render->wake_seen) return 0;
+    render->wake_seen = count;
+    render_resume(render);
+    return 1;
+}
+
+// An event landing within the next period also ends an idle spell
+static int render_event_due(IrixAudioRender* render) {
+    IrixAudioStream* stream = render->stream;
+    long long next;
+
+    if (!stream->events) return 0;
+    next = irix_audio_events_next(stream->events);
+    return next >= 0 && next < stream->position + render->params.period_frames;
+}
+
+// Pass one idle period, returning early if woken
+static int render_idle_period(IrixAudioRender* render) {
+    long long deadline = render_now() + render->period_ns;
+    long long slice = render->period_ns / RENDER_IDLE_SLICES;
+    struct timespec ts;
+    int due = 0;
+
+    // Stands in for the blocking write the period would otherwise make
+    irix_audio_rt_io_begin();
+    for (;;) {
+        long long left;
+        IRIX_AUDIO_BARRIER();
+        if (render->wake_count != render->wake_seen) break;
+        due = render_event_due(render);
+        if (due) break;
+        left = deadline - render_now();
+        if (left <= 0) break;
+        if (left > slice) left = slice;
+        ts.tv_sec = left / 1000000000LL;
+        ts.tv_nsec = left % 1000000000LL;
+        nanosleep(&ts, NULL);
+    }
+    irix_audio_rt_io_end();
+
+    if (render_take_wake(render)) return 1;
+    if (due) {
+        render_resume(render);
+        return 1;
+    }
+    if (render->params.idle_mode == IRIX_AUDIO_IDLE_ZERO) {
+        if (render_zero_fill(render) < 0) return -1;
+    } else {
+        // Nothing is queued, but the stream's timeline moves on
+        render->stream->position += render->params.period_frames;
+    }
+    render->stats.periods_idle++;
+    return 0;
+}
+
+// Open a render engine on an output stream
+IrixAudioRender* irix_audio_render_open(IrixAudioStream* stream, IrixAudioRenderCallback callback,
+                                        void* user, IrixAudioRenderParams* params) {
+    IrixAudioRender* render;
+
+    if (!stream || stream->mode != IRIX_AUDIO_OUTPUT || !callback) {
+        irix_audio_set_error("Render requires an output stream and a callback");
+        return NULL;
+    }
+
+    render = calloc(1, sizeof(IrixAudioRender));
+    if (!render) {
+        irix_audio_set_error("Cannot allocate render engine");
+        return NULL;
+    }
+    render->stream = stream;
+    render->callback = callback;
+    render->user = user;
+    if (params) render->params = *params;
+    if (render->params.period_frames <= 0) render->params.period_frames = stream->buffer_size;
+    if (render->params.period_frames <= 0) render->params.period_frames = 256;
+    if (render->params.silence_db == 0.0) render->params.silence_db = -90.0;
+    if (render->params.idle_periods == 0) {
+        render->params.idle_periods = (stream->sample_rate / 2 + render->params.period_frames - 1) /
+                                      render->params.period_frames;
+    }
+    if (render->params.idle_fill_frames <= 0) {
+        render->params.idle_fill_frames = 2 * render->params.period_frames;
+    }
+
+    render->threshold = (float)pow(10.0, render->params.silence_db / 20.0);
+    render->period_ns = (long long)render->params.period_frames * 1000000000LL / stream->sample_rate;
+    render->buffer = malloc(render->params.period_frames * stream->channels * sizeof(float));
+    if (!render->buffer) {
+        irix_audio_set_error("Cannot allocate render buffer");
+        free(render);
+        return NULL;
+    }
+
+    return render;
+}
+
+// Close a render engine (the stream stays open)
+void irix_audio_render_close(IrixAudioRender* render) {
+    if (!render) return;
+
+    free(render->buffer);
+    free(render);
+}
+
+// Run one period. Returns 1 if the callback rendered it, 0 if the engine
+// was idle, -1 on error or when the callback stops the engine.
+int irix_audio_render_process(IrixAudioRender* render) {
+    IrixAudioStream* stream;
+    IrixAudioTraceMark mark;
+    int frames, channels, rendered;
+    int done = 0;
+
+    if (!render) {
+        irix_audio_set_error("Invalid render engine");
+        return -1;
+    }
+    stream = render->stream;
+    frames = render->params.period_frames;
+    channels = stream->channels;
+
+    render_take_wake(render);
+    if (render->idle) {
+        int woken = render_idle_period(render);
+        if (woken <= 0) return woken;
+    }
+
+    // Render and write up to each event's frame, then apply it
+    while (done < frames) {
+        float* segment = render->buffer + done * channels;
+        int n = frames - done;
+
+        if (stream->events) n = irix_audio_events_run(stream->events, stream, stream->position, n);
+        if (stream->trace) irix_audio_trace_begin(stream->trace, &mark, -1);
+        rendered = render->callback(render->user, segment, n);
+        if (stream->trace) {
+            irix_audio_trace_end(stream->trace, &mark, IRIX_AUDIO_TRACE_RENDER, n, rendered);
+        }
+        if (rendered < 0) {
+            irix_audio_set_error("Render callback stopped the engine");
+            return -1;
+        }
+        if (rendered > n) rendered = n;
+        if (rendered < n) memset(segment + rendered * channels, 0, (n - rendered) * channels * sizeof(float));
+        if (irix_audio_write_frames(stream, segment, n) < 0) return -1;
+        done += n;
+    }
+    render->stats.periods_rendered++;
+
+    if (render_silent(render->buffer, frames * channels, render->threshold)) {
+        render->stats.periods_silent++;
+        if (render->params.idle_periods > 0 && ++render->silent_run >= render->params.idle_periods) {
+            render->idle = 1;
+            render->stats.idle_entries++;
+        }
+    } else {
+        render->silent_run = 0;
+    }
+
+    return 1;
+}
+
+// Resume an idle engine; safe from any thread
+void irix_audio_render_wake(IrixAudioRender* render) {
+    if (!render) return;
+
+    // Several threads may wake at once; a lost increment would be a lost wake
+    IRIX_AUDIO_ATOMIC_INC(&render->wake_count);
+    IRIX_AUDIO_BARRIER();
+}
+
+int irix_audio_render_get_stats(IrixAudioRender* render, IrixAudioRenderStats* stats) {
+    if (!render || !stats) {
+        irix_audio_set_error("Invalid render engine");
+        return -1;
+    }
+    *stats = render->stats;
+    stats->idle = render->idle;
+    return 0;
+}
@@ -0,0 +1,414 @@
+// IRIX Audio Library - Real-time safety mode
+// Locks memory, raises the I/O thread to a real-time priority and, in
+// builds with IRIX_AUDIO_RT_DEBUG, reports allocations, locks and
+// blocking calls made from guarded audio threads.
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __sgi
+#include <sys/lock.h>
+#endif
+
+#define RT_MAX_THREADS 8
+#define RT_STACK_PREFAULT (64 * 1024)
+
+// Guarded audio thread
+typedef struct {
+    pthread_t thread;
+    int active;
+    int streams;                // Guarded streams enabled on this thread
+    int in_io;                  // Inside the library's own audio I/O call
+} RtThread;
+
+static RtThread rt_threads[RT_MAX_THREADS];
+static volatile int rt_guard_active = 0;
+static IrixAudioRtReport rt_report;
+static int rt_memory_locked = 0;
+
+// Touch the stack so the I/O thread does not fault it in later
+static void rt_prefault_stack(void) {
+    volatile char stack[RT_STACK_PREFAULT];
+    int i;
+
+    for (i = 0; i < RT_STACK_PREFAULT; i += 512) {
+        stack[i] = 0;
+    }
+    (void)stack[0];
+}
+
+// Lock all current and future pages of the process
+static int rt_lock_memory(void) {
+    if (rt_memory_locked) return 0;
+
+#ifdef __sgi
+    if (plock(PROCLOCK) < 0 && errno != EINVAL) {
+        // EINVAL: already locked
+        irix_audio_set_error("Cannot lock memory: %s", strerror(errno));
+        return -1;
+    }
+#else
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        irix_audio_set_error("Cannot lock memory: %s", strerror(errno));
+        return -1;
+    }
+#endif
+    rt_memory_locked = 1;
+    return 0;
+}
+
+// Raise the calling thread to a fixed real-time priority
+static int rt_raise_priority(int priority) {
+    struct sched_param param;
+    int min = sched_get_priority_min(SCHED_FIFO);
+    int max = sched_get_priority_max(SCHED_FIFO);
+    int result;
+
+    if (priority <= 0) priority = (min + max) / 2;
+    if (priority < min) priority = min;
+    if (priority > max) priority = max;
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0) {
+        irix_audio_set_error("Cannot set real-time priority %d: %s", priority, strerror(result));
+        return -1;
+    }
+    return 0;
+}
+
+// Index of a thread in the guard table, or -1
+static int rt_find(pthread_t thread) {
+    int i;
+
+    for (i = 0; i < RT_MAX_THREADS; i++) {
+        if (rt_threads[i].active && pthread_equal(rt_threads[i].thread, thread)) return i;
+    }
+    return -1;
+}
+
+static int rt_find_thread(void) {
+    return rt_find(pthread_self());
+}
+
+// Drop a guard table entry
+static void rt_release(int index) {
+    int i;
+
+    rt_threads[index].active = 0;
+    rt_threads[index].streams = 0;
+
+    rt_guard_active = 0;
+    for (i = 0; i < RT_MAX_THREADS; i++) {
+        if (rt_threads[i].active) rt_guard_active = 1;
+    }
+}
+
+#ifdef IRIX_AUDIO_RT_DEBUG
+// Register the calling thread for the guard, once per stream
+static void rt_guard_thread(void) {
+    int i = rt_find_thread();
+
+    if (i >= 0) {
+        rt_threads[i].streams++;
+        return;
+    }
+    for (i = 0; i < RT_MAX_THREADS; i++) {
+        if (!rt_threads[i].active) {
+            rt_threads[i].thread = pthread_self();
+            rt_threads[i].streams = 1;
+            rt_threads[i].in_io = 0;
+            IRIX_AUDIO_BARRIER();
+            rt_threads[i].active = 1;
+            rt_guard_active = 1;
+            return;
+        }
+    }
+}
+#endif
+
+// Enable real-time mode for a stream; call from its I/O thread
+int irix_audio_rt_enable(IrixAudioStream* stream, IrixAudioRtParams* params) {
+    int frames, result = 0;
+
+    if (!stream || !params) {
+        irix_audio_set_error("Invalid real-time parameters");
+        return -1;
+    }
+
+    // Preallocate a period buffer the application can use instead of malloc
+    frames = (stream->buffer_size > 0) ? stream->buffer_size : 1024;
+    if (!stream->rt_buffer) {
+        stream->rt_buffer = calloc(frames * stream->channels, sizeof(double));
+        if (!stream->rt_buffer) {
+            irix_audio_set_error("Cannot allocate real-time buffer");
+            return -1;
+        }
+    }
+
+    if (params->flags & IRIX_AUDIO_RT_LOCK_MEMORY) {
+        if (rt_lock_memory() < 0) result = -1;
+    }
+    rt_prefault_stack();
+    memset(stream->rt_buffer, 0, frames * stream->channels * sizeof(double));
+
+    if (params->flags & IRIX_AUDIO_RT_PRIORITY) {
+        if (rt_raise_priority(params->priority) < 0) result = -1;
+    }
+
+    // Re-enabling moves the guard to the calling thread
+    irix_audio_rt_disable(stream);
+
+#ifdef IRIX_AUDIO_RT_DEBUG
+    if (params->flags & IRIX_AUDIO_RT_GUARD) {
+        rt_guard_thread();
+    }
+#endif
+
+    stream->rt_flags = params->flags;
+    stream->rt_thread = pthread_self();
+    return result;
+}
+
+// Stop guarding the thread that enabled the stream; safe from any thread
+void irix_audio_rt_disable(IrixAudioStream* stream) {
+    int index;
+
+    if (!(stream->rt_flags & IRIX_AUDIO_RT_GUARD)) return;
+    stream->rt_flags &= ~IRIX_AUDIO_RT_GUARD;
+
+    index = rt_find(stream->rt_thread);
+    if (index >= 0 && --rt_threads[index].streams <= 0) rt_release(index);
+}
+
+// Period buffer allocated by irix_audio_rt_enable (buffer_size frames of up to 64-bit samples)
+void* irix_audio_rt_buffer(IrixAudioStream* stream) {
+    return stream ? stream->rt_buffer : NULL;
+}
+
+// Stop guarding the calling thread, whatever streams it enabled
+void irix_audio_rt_release_thread(void) {
+    int index = rt_find_thread();
+
+    if (index >= 0) rt_release(index);
+}
+
+// Get the guard report (all zero unless built with IRIX_AUDIO_RT_DEBUG)
+int irix_audio_rt_get_report(IrixAudioRtReport* report) {
+    if (!report) {
+        irix_audio_set_error("Invalid report");
+        return -1;
+    }
+    *report = rt_report;
+    return 0;
+}
+
+void irix_audio_rt_reset_report(void) {
+    memset(&rt_report, 0, sizeof(rt_report));
+}
+
+#ifdef IRIX_AUDIO_RT_DEBUG
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/time.h>
+
+// Audio I/O brackets: blocking inside AL is the sanctioned wait
+void irix_audio_rt_io_begin(void) {
+    int index;
+
+    if (!rt_guard_active) return;
+    index = rt_find_thread();
+    if (index < 0) return;
+    rt_threads[index].in_io = 1;
+    rt_report.io_calls++;
+}
+
+void irix_audio_rt_io_end(void) {
+    int index;
+
+    if (!rt_guard_active) return;
+    index = rt_find_thread();
+    if (index >= 0) rt_threads[index].in_io = 0;
+}
+
+// Record a forbidden call if it came from a guarded thread
+static void rt_violation(unsigned long* counter, const char* call) {
+    int index;
+
+    if (!rt_guard_active) return;
+    index = rt_find_thread();
+    if (index < 0 || rt_threads[index].in_io) return;
+
+    (*counter)++;
+    if (!rt_report.first_violation) {
+        rt_report.first_violation = call;
+        rt_report.first_violation_io_call = rt_report.io_calls;
+    }
+}
+
+// Print the report to stderr if anything was caught
+void irix_audio_rt_print_report(void) {
+    const IrixAudioRtReport* r = &rt_report;
+    int saved = rt_guard_active;
+
+    if (!r->first_violation) return;
+
+    // Printing allocates and writes; do not report ourselves
+    rt_guard_active = 0;
+    fprintf(stderr, "irix_audio: real-time violations on the audio thread: "
+            "%lu allocations, %lu frees, %lu locks, %lu blocking calls; "
+            "first was %s() after %lu I/O calls\n",
+            r->allocations, r->frees, r->locks, r->blocking_calls,
+            r->first_violation, r->first_violation_io_call);
+    rt_guard_active = saved;
+}
+
+// Interposers: resolved lazily from the next object (libc, libpthread)
+
+static void* (*real_malloc)(size_t);
+static void* (*real_calloc)(size_t, size_t);
+static void* (*real_realloc)(void*, size_t);
+static void (*real_free)(void*);
+static int (*real_mutex_lock)(pthread_mutex_t*);
+static int (*real_cond_wait)(pthread_cond_t*, pthread_mutex_t*);
+static int (*real_sem_wait)(sem_t*);
+static int (*real_nanosleep)(const struct timespec*, struct timespec*);
+static int (*real_usleep)(useconds_t);
+static ssize_t (*real_read)(int, void*, size_t);
+static ssize_t (*real_write)(int, const void*, size_t);
+
+// dlsym may allocate before malloc is resolved; serve it from here
+static char rt_bootstrap[8192];
+static size_t rt_bootstrap_used = 0;
+static volatile int rt_resolving = 0;
+
+static void* rt_bootstrap_alloc(size_t size) {
+    void* p;
+
+    size = (size + 15) & ~(size_t)15;
+    if (rt_bootstrap_used + size > sizeof(rt_bootstrap)) return NULL;
+    p = rt_bootstrap + rt_bootstrap_used;
+    rt_bootstrap_used += size;
+    return p;
+}
+
+static int rt_is_bootstrap(void* p) {
+    return (char*)p >= rt_bootstrap && (char*)p < rt_bootstrap + sizeof(rt_bootstrap);
+}
+
+static void rt_resolve(void) {
+    rt_resolving = 1;
+    real_malloc = (void* (*)(size_t))dlsym(RTLD_NEXT, "malloc");
+    real_calloc = (void* (*)(size_t, size_t))dlsym(RTLD_NEXT, "calloc");
+    real_realloc = (void* (*)(void*, size_t))dlsym(RTLD_NEXT, "realloc");
+    real_free = (void (*)(void*))dlsym(RTLD_NEXT, "free");
+    real_mutex_lock = (int (*)(pthread_mutex_t*))dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    real_cond_wait = (int (*)(pthread_cond_t*, pthread_mutex_t*))dlsym(RTLD_NEXT, "pthread_cond_wait");
+    real_sem_wait = (int (*)(sem_t*))dlsym(RTLD_NEXT, "sem_wait");
+    real_nanosleep = (int (*)(const struct timespec*, struct timespec*))dlsym(RTLD_NEXT, "nanosleep");
+    real_usleep = (int (*)(useconds_t))dlsym(RTLD_NEXT, "usleep");
+    real_read = (ssize_t (*)(int, void*, size_t))dlsym(RTLD_NEXT, "read");
+    real_write = (ssize_t (*)(int, const void*, size_t))dlsym(RTLD_NEXT, "write");
+    rt_resolving = 0;
+}
+
+void* malloc(size_t size) {
+    if (!real_malloc) {
+        if (rt_resolving) return rt_bootstrap_alloc(size);
+        rt_resolve();
+    }
+    rt_violation(&rt_report.allocations, "malloc");
+    return real_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (!real_calloc) {
+        if (rt_resolving) return rt_bootstrap_alloc(count * size);  // static, already zero
+        rt_resolve();
+    }
+    rt_violation(&rt_report.allocations, "calloc");
+    return real_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+    if (rt_is_bootstrap(p)) {
+        // libc never saw this block: move it into a fresh allocation.
+        // Its size is not recorded, so copy what the arena can hold.
+        size_t available = rt_bootstrap + sizeof(rt_bootstrap) - (char*)p;
+        void* q = malloc(size);
+        if (q) memcpy(q, p, size < available ? size : available);
+        return q;
+    }
+    if (!real_realloc) {
+        if (rt_resolving) return p ? NULL : rt_bootstrap_alloc(size);
+        rt_resolve();
+    }
+    rt_violation(&rt_report.allocations, "realloc");
+    return real_realloc(p, size);
+}
+
+void free(void* p) {
+    if (!p || rt_is_bootstrap(p)) return;
+    if (!real_free) rt_resolve();
+    rt_violation(&rt_report.frees, "free");
+    real_free(p);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    if (!real_mutex_lock) rt_resolve();
+    rt_violation(&rt_report.locks, "pthread_mutex_lock");
+    return real_mutex_lock(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    if (!real_cond_wait) rt_resolve();
+    rt_violation(&rt_report.locks, "pthread_cond_wait");
+    return real_cond_wait(cond, mutex);
+}
+
+int sem_wait(sem_t* sem) {
+    if (!real_sem_wait) rt_resolve();
+    rt_violation(&rt_report.locks, "sem_wait");
+    return real_sem_wait(sem);
+}
+
+int nanosleep(const struct timespec* request, struct timespec* remain) {
+    if (!real_nanosleep) rt_resolve();
+    rt_violation(&rt_report.blocking_calls, "nanosleep");
+    return real_nanosleep(request, remain);
+}
+
+int usleep(useconds_t usec) {
+    if (!real_usleep) rt_resolve();
+    rt_violation(&rt_report.blocking_calls, "usleep");
+    return real_usleep(usec);
+}
+
+ssize_t read(int fd, void* buffer, size_t count) {
+    if (!real_read) rt_resolve();
+    rt_violation(&rt_report.blocking_calls, "read");
+    return real_read(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void* buffer, size_t count) {
+    if (!real_write) rt_resolve();
+    rt_violation(&rt_report.blocking_calls, "write");
+    return real_write(fd, buffer, count);
+}
+
+#else
+
+void irix_audio_rt_print_report(void) {
+}
+
+#endif // IRIX_AUDIO_RT_DEBUG
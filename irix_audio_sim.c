@@ -0,0 +1,531 @@
+// IRIX Audio Library - Simulated audio device
+// AL replacement for IRIX_AUDIO_SIMULATE builds, see irix_audio_sim.h.
+// Device time is derived from the host monotonic clock; every AL call
+// first advances the device to the current time, moving frames out of
+// output queues into the signal path and from the delayed path into the
+// input queues. Blocking reads and writes sleep in short steps.
+
+#ifdef IRIX_AUDIO_SIMULATE
+
+#include "irix_audio_sim.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_MAX_PORTS 16
+#define SIM_CHANNELS 8              // Channels on the signal path
+#define SIM_PATH_FRAMES 262144      // Path history, bounds the delay (power of two)
+#define SIM_DEFAULT_RATE 44100
+#define SIM_DEFAULT_QUEUE 8192      // Port queue when alSetQueueSize is not used
+#define SIM_MAX_WAIT_NSEC 2000000   // Longest sleep while a read or write waits
+#define SIM_FIXED_ONE 4294967296.0  // alDoubleToFixed scale
+
+struct IrixAudioSimConfig {
+    int channels;
+    int queue_size;
+};
+
+struct IrixAudioSimPort {
+    int input;
+    int channels;
+    int queue_size;
+    float* queue;               // queue_size interleaved frames
+    int head;                   // Oldest frame
+    int fill;
+    int active;                 // Output has been written to
+};
+
+static struct {
+    pthread_mutex_t lock;
+    int started;
+    double rate;
+    struct timespec base_time;  // Host time of base_frame
+    long long base_frame;
+    long long frame;            // Device frames simulated so far
+    double delay;
+    int delay_set;
+    double input_step;          // Input frames per device frame (rate skew)
+    double input_phase;
+    float* path;                // SIM_PATH_FRAMES x SIM_CHANNELS
+    ALport ports[SIM_MAX_PORTS];
+    unsigned long xruns;
+} sim = { PTHREAD_MUTEX_INITIALIZER };
+
+static int sim_error = 0;
+
+static const char* sim_error_strings[] = {
+    "No error",
+    "Invalid config",
+    "Invalid port",
+    "Invalid resource",
+    "Invalid parameter",
+    "Invalid channel count",
+    "Invalid queue size",
+    "No ports available",
+    "Out of memory",
+    "Unsupported sample format",
+    "Invalid float maximum"
+};
+
+int oserror(void) {
+    return sim_error;
+}
+
+const char* alGetErrorString(int error) {
+    if (error < 0 || error >= (int)(sizeof(sim_error_strings) / sizeof(sim_error_strings[0]))) {
+        return "Unknown error";
+    }
+    return sim_error_strings[error];
+}
+
+static double sim_elapsed(const struct timespec* since) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - since->tv_sec) + (double)(now.tv_nsec - since->tv_nsec) * 1e-9;
+}
+
+// Start the device clock on first use; called with the lock held
+static int sim_start(void) {
+    const char* delay;
+
+    if (sim.started) return 0;
+
+    sim.path = calloc((size_t)SIM_PATH_FRAMES * SIM_CHANNELS, sizeof(float));
+    if (!sim.path) {
+        sim_error = AL_BAD_OUT_OF_MEM;
+        return -1;
+    }
+    if (!sim.delay_set) {
+        delay = getenv("IRIX_AUDIO_SIM_DELAY");
+        sim.delay = delay ? atof(delay) : 0.0;
+        if (sim.delay < 0.0) sim.delay = 0.0;
+        if (sim.delay > SIM_PATH_FRAMES - 2) sim.delay = SIM_PATH_FRAMES - 2;
+    }
+    sim.rate = SIM_DEFAULT_RATE;
+    if (sim.input_step <= 0.0) sim.input_step = 1.0;
+    clock_gettime(CLOCK_MONOTONIC, &sim.base_time);
+    sim.started = 1;
+    return 0;
+}
+
+static size_t sim_path_index(long long frame) {
+    return (size_t)(frame & (SIM_PATH_FRAMES - 1)) * SIM_CHANNELS;
+}
+
+// Run the device up to the current time; called with the lock held
+static void sim_advance(void) {
+    long long target = sim.base_frame + (long long)(sim_elapsed(&sim.base_time) * sim.rate);
+    int delay_frames = (int)sim.delay;
+    float frac = (float)(sim.delay - delay_frames);
+    // Hermite taps; the newest needs delay_frames >= 1 to be in the past
+    int newest = (delay_frames > 0) ? delay_frames - 1 : delay_frames;
+    int p, c;
+
+    for (; sim.frame < target; sim.frame++) {
+        float* now = sim.path + sim_path_index(sim.frame);
+        const float* xm1 = sim.path + sim_path_index(sim.frame - newest);
+        const float* x0 = sim.path + sim_path_index(sim.frame - delay_frames);
+        const float* x1 = sim.path + sim_path_index(sim.frame - delay_frames - 1);
+        const float* x2 = sim.path + sim_path_index(sim.frame - delay_frames - 2);
+
+        // Outputs play into the path
+        memset(now, 0, SIM_CHANNELS * sizeof(float));
+        for (p = 0; p < SIM_MAX_PORTS; p++) {
+            ALport port = sim.ports[p];
+            if (!port || port->input) continue;
+            if (port->fill == 0) {
+                if (port->active) sim.xruns++;
+                continue;
+            }
+            for (c = 0; c < port->channels; c++) {
+                now[c % SIM_CHANNELS] += port->queue[port->head * port->channels + c];
+            }
+            if (++port->head == port->queue_size) port->head = 0;
+            port->fill--;
+        }
+
+        // Inputs capture the delayed path on their own (skewed) clock,
+        // dropping or repeating a path frame as the clocks slip
+        for (sim.input_phase += sim.input_step; sim.input_phase >= 1.0; sim.input_phase -= 1.0) {
+            for (p = 0; p < SIM_MAX_PORTS; p++) {
+                ALport port = sim.ports[p];
+                float* frame;
+                if (!port || !port->input) continue;
+                if (port->fill == port->queue_size) {
+                    sim.xruns++;
+                    continue;
+                }
+                frame = port->queue + ((port->head + port->fill) % port->queue_size) * port->channels;
+                for (c = 0; c < port->channels; c++) {
+                    int k = c % SIM_CHANNELS;
+                    float a = 0.5f * (x1[k] - xm1[k]);
+                    float b = xm1[k] - 2.5f * x0[k] + 2.0f * x1[k] - 0.5f * x2[k];
+                    float d = 0.5f * (x2[k] - xm1[k]) + 1.5f * (x0[k] - x1[k]);
+                    frame[c] = ((d * frac + b) * frac + a) * frac + x0[k];
+                }
+                port->fill++;
+            }
+        }
+    }
+}
+
+// Sleep for roughly the time the device takes to play the given frames
+static void sim_wait(int frames) {
+    struct timespec ts;
+    double seconds = frames / (sim.rate > 0.0 ? sim.rate : SIM_DEFAULT_RATE);
+
+    if (seconds > SIM_MAX_WAIT_NSEC * 1e-9) seconds = SIM_MAX_WAIT_NSEC * 1e-9;
+    ts.tv_sec = 0;
+    ts.tv_nsec = (long)(seconds * 1e9);
+    nanosleep(&ts, NULL);
+}
+
+int alQueryValues(int resource, int param, ALvalue* values, int count, ALpv* quals, int qual_count) {
+    (void)quals;
+    (void)qual_count;
+
+    if (resource == AL_SYSTEM && param == AL_DEVICES) {
+        if (values && count > 0) values[0].i = AL_DEFAULT_OUTPUT;
+        if (values && count > 1) values[1].i = AL_DEFAULT_INPUT;
+        return 2;
+    }
+    if (resource == AL_SYSTEM && (param == AL_DEFAULT_OUTPUT || param == AL_DEFAULT_INPUT)) {
+        if (values && count > 0) values[0].i = param;
+        return 1;
+    }
+    if ((resource == AL_DEFAULT_OUTPUT || resource == AL_DEFAULT_INPUT) && param == AL_CHANNELS) {
+        if (values && count > 0) values[0].i = SIM_CHANNELS;
+        return 1;
+    }
+
+    sim_error = AL_BAD_PARAM;
+    return -1;
+}
+
+int alGetParamInfo(int resource, int param, ALparamInfo* info) {
+    if ((resource != AL_DEFAULT_OUTPUT && resource != AL_DEFAULT_INPUT) || param != AL_RATE || !info) {
+        sim_error = AL_BAD_PARAM;
+        return -1;
+    }
+
+    memset(info, 0, sizeof(ALparamInfo));
+    info->resource = resource;
+    info->param = param;
+    strcpy(info->name, "Sample Rate");
+    info->initial.i = SIM_DEFAULT_RATE;
+    info->min.i = 4000;
+    info->max.i = 192000;
+    return 0;
+}
+
+long long alDoubleToFixed(double value) {
+    return (long long)(value * SIM_FIXED_ONE);
+}
+
+double alFixedToDouble(long long value) {
+    return (double)value / SIM_FIXED_ONE;
+}
+
+// Only the sample rate has an effect; the device runs one clock
+int alSetParams(int resource, ALpv* pvs, int count) {
+    int i;
+
+    if (resource != AL_DEFAULT_OUTPUT && resource != AL_DEFAULT_INPUT) {
+        sim_error = AL_BAD_RESOURCE;
+        return -1;
+    }
+
+    pthread_mutex_lock(&sim.lock);
+    if (sim_start() < 0) {
+        pthread_mutex_unlock(&sim.lock);
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        if (pvs[i].param == AL_RATE) {
+            double rate = alFixedToDouble(pvs[i].value.ll);
+            if (rate < 4000.0 || rate > 192000.0) {
+                pvs[i].sizeOut = -1;
+                continue;
+            }
+            // Rebase the clock so device time stays continuous
+            sim_advance();
+            clock_gettime(CLOCK_MONOTONIC, &sim.base_time);
+            sim.base_frame = sim.frame;
+            sim.rate = rate;
+        }
+    }
+    pthread_mutex_unlock(&sim.lock);
+    return count;
+}
+
+ALconfig alNewConfig(void) {
+    ALconfig config = malloc(sizeof(struct IrixAudioSimConfig));
+
+    if (!config) {
+        sim_error = AL_BAD_OUT_OF_MEM;
+        return NULL;
+    }
+    config->channels = 2;
+    config->queue_size = SIM_DEFAULT_QUEUE;
+    return config;
+}
+
+int alFreeConfig(ALconfig config) {
+    if (!config) {
+        sim_error = AL_BAD_CONFIG;
+        return -1;
+    }
+    free(config);
+    return 0;
+}
+
+int alSetChannels(ALconfig config, int channels) {
+    if (!config) {
+        sim_error = AL_BAD_CONFIG;
+        return -1;
+    }
+    if (channels <= 0 || channels > SIM_CHANNELS) {
+        sim_error = AL_BAD_CHANNELS;
+        return -1;
+    }
+    config->channels = channels;
+    return 0;
+}
+
+int alSetQueueSize(ALconfig config, int frames) {
+    if (!config) {
+        sim_error = AL_BAD_CONFIG;
+        return -1;
+    }
+    if (frames <= 0) {
+        sim_error = AL_BAD_QSIZE;
+        return -1;
+    }
+    config->queue_size = frames;
+    return 0;
+}
+
+int alSetSampFmt(ALconfig config, int format) {
+    if (!config) {
+        sim_error = AL_BAD_CONFIG;
+        return -1;
+    }
+    if (format != AL_SAMPFMT_FLOAT) {
+        sim_error = AL_BAD_SAMPFMT;
+        return -1;
+    }
+    return 0;
+}
+
+int alSetFloatMax(ALconfig config, double max) {
+    if (!config) {
+        sim_error = AL_BAD_CONFIG;
+        return -1;
+    }
+    if (max <= 0.0) {
+        sim_error = AL_BAD_FLOATMAX;
+        return -1;
+    }
+    return 0;
+}
+
+ALport alOpenPort(const char* name, const char* mode, ALconfig config) {
+    ALport port;
+    int i;
+
+    (void)name;
+    if (!mode || (mode[0] != 'r' && mode[0] != 'w')) {
+        sim_error = AL_BAD_PARAM;
+        return NULL;
+    }
+
+    port = calloc(1, sizeof(struct IrixAudioSimPort));
+    if (!port) {
+        sim_error = AL_BAD_OUT_OF_MEM;
+        return NULL;
+    }
+    port->input = (mode[0] == 'r');
+    port->channels = config ? config->channels : 2;
+    port->queue_size = config ? config->queue_size : SIM_DEFAULT_QUEUE;
+    port->queue = malloc((size_t)port->queue_size * port->channels * sizeof(float));
+    if (!port->queue) {
+        sim_error = AL_BAD_OUT_OF_MEM;
+        free(port);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&sim.lock);
+    if (sim_start() < 0) {
+        pthread_mutex_unlock(&sim.lock);
+        free(port->queue);
+        free(port);
+        return NULL;
+    }
+    sim_advance();
+    for (i = 0; i < SIM_MAX_PORTS && sim.ports[i]; i++) {
+    }
+    if (i == SIM_MAX_PORTS) {
+        pthread_mutex_unlock(&sim.lock);
+        sim_error = AL_BAD_NO_PORTS;
+        free(port->queue);
+        free(port);
+        return NULL;
+    }
+    sim.ports[i] = port;
+    pthread_mutex_unlock(&sim.lock);
+    return port;
+}
+
+int alClosePort(ALport port) {
+    int i;
+
+    pthread_mutex_lock(&sim.lock);
+    for (i = 0; i < SIM_MAX_PORTS && sim.ports[i] != port; i++) {
+    }
+    if (!port || i == SIM_MAX_PORTS) {
+        pthread_mutex_unlock(&sim.lock);
+        sim_error = AL_BAD_PORT;
+        return -1;
+    }
+    sim_advance();
+    sim.ports[i] = NULL;
+    pthread_mutex_unlock(&sim.lock);
+
+    free(port->queue);
+    free(port);
+    return 0;
+}
+
+// Queue frames on an output port, or silence when buffer is NULL
+static int sim_write(ALport port, const float* buffer, int frames) {
+    int done = 0;
+
+    if (!port || port->input || frames < 0) {
+        sim_error = AL_BAD_PORT;
+        return -1;
+    }
+
+    while (done < frames) {
+        int n, i;
+
+        pthread_mutex_lock(&sim.lock);
+        sim_advance();
+        port->active = 1;
+        n = port->queue_size - port->fill;
+        if (n > frames - done) n = frames - done;
+        for (i = 0; i < n; i++) {
+            float* frame = port->queue + ((port->head + port->fill) % port->queue_size) * port->channels;
+            if (buffer) {
+                memcpy(frame, buffer + (size_t)(done + i) * port->channels, port->channels * sizeof(float));
+            } else {
+                memset(frame, 0, port->channels * sizeof(float));
+            }
+            port->fill++;
+        }
+        pthread_mutex_unlock(&sim.lock);
+
+        done += n;
+        if (done < frames) sim_wait(frames - done);
+    }
+    return 0;
+}
+
+int alWriteFrames(ALport port, void* buffer, int frames) {
+    return sim_write(port, (const float*)buffer, frames);
+}
+
+int alZeroFrames(ALport port, int frames) {
+    return sim_write(port, NULL, frames);
+}
+
+int alReadFrames(ALport port, void* buffer, int frames) {
+    float* out = (float*)buffer;
+    int done = 0;
+
+    if (!port || !port->input || frames < 0) {
+        sim_error = AL_BAD_PORT;
+        return -1;
+    }
+
+    while (done < frames) {
+        int n, i;
+
+        pthread_mutex_lock(&sim.lock);
+        sim_advance();
+        n = port->fill;
+        if (n > frames - done) n = frames - done;
+        for (i = 0; i < n; i++) {
+            memcpy(out + (size_t)(done + i) * port->channels, port->queue + port->head * port->channels,
+                   port->channels * sizeof(float));
+            if (++port->head == port->queue_size) port->head = 0;
+        }
+        port->fill -= n;
+        pthread_mutex_unlock(&sim.lock);
+
+        done += n;
+        if (done < frames) sim_wait(frames - done);
+    }
+    return 0;
+}
+
+int alGetFilled(ALport port) {
+    int fill;
+
+    if (!port) {
+        sim_error = AL_BAD_PORT;
+        return -1;
+    }
+    pthread_mutex_lock(&sim.lock);
+    sim_advance();
+    fill = port->fill;
+    pthread_mutex_unlock(&sim.lock);
+    return fill;
+}
+
+int alGetFillable(ALport port) {
+    int fill = alGetFilled(port);
+
+    return (fill < 0) ? -1 : port->queue_size - fill;
+}
+
+void irix_audio_sim_set_delay(double frames) {
+    if (frames < 0.0) frames = 0.0;
+    if (frames > SIM_PATH_FRAMES - 2) frames = SIM_PATH_FRAMES - 2;
+
+    pthread_mutex_lock(&sim.lock);
+    if (sim.started) sim_advance();
+    sim.delay = frames;
+    sim.delay_set = 1;
+    pthread_mutex_unlock(&sim.lock);
+}
+
+double irix_audio_sim_get_delay(void) {
+    double delay;
+
+    pthread_mutex_lock(&sim.lock);
+    sim_start();
+    delay = sim.delay;
+    pthread_mutex_unlock(&sim.lock);
+    return delay;
+}
+
+void irix_audio_sim_set_rate_skew(double ppm) {
+    pthread_mutex_lock(&sim.lock);
+    if (sim.started) sim_advance();
+    sim.input_step = 1.0 / (1.0 + ppm * 1e-6);
+    pthread_mutex_unlock(&sim.lock);
+}
+
+unsigned long irix_audio_sim_get_xruns(void) {
+    unsigned long xruns;
+
+    pthread_mutex_lock(&sim.lock);
+    if (sim.started) sim_advance();
+    xruns = sim.xruns;
+    pthread_mutex_unlock(&sim.lock);
+    return xruns;
+}
+
+#endif // IRIX_AUDIO_SIMULATE
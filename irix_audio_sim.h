@@ -0,0 +1,123 @@
+// IRIX Audio Library - Simulated audio device
+// Stands in for <dmedia/audio.h> in IRIX_AUDIO_SIMULATE builds so the
+// library and examples run on hosts without the IRIX Audio Library. Only
+// the parts of the AL interface the library uses are provided.
+//
+// The device runs from the host clock. Output ports are mixed into a
+// shared signal path and input ports capture that path after a
+// configurable delay, so output played on one port comes back on every
+// input port.
+
+#ifndef IRIX_AUDIO_SIM_H
+#define IRIX_AUDIO_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct IrixAudioSimPort* ALport;
+typedef struct IrixAudioSimConfig* ALconfig;
+typedef long long stamp_t;
+
+typedef union {
+    int i;
+    long long ll;
+    void* ptr;
+} ALvalue;
+
+typedef struct {
+    int param;
+    ALvalue value;
+    int sizeIn;
+    int size1In;
+    int size2In;
+    int sizeOut;
+    int size1Out;
+    int size2Out;
+} ALpv;
+
+typedef struct {
+    int resource;
+    int param;
+    int valueType;
+    int maxElems;
+    int maxElems2;
+    int elementType;
+    char name[32];
+    ALvalue initial;
+    ALvalue min;
+    ALvalue max;
+    ALvalue minDelta;
+    ALvalue maxDelta;
+    int specialVals;
+    int operations;
+} ALparamInfo;
+
+// Resources and parameters
+#define AL_SYSTEM 1
+#define AL_DEFAULT_OUTPUT 2
+#define AL_DEFAULT_INPUT 3
+#define AL_DEVICES 10
+#define AL_CHANNELS 11
+#define AL_RATE 12
+#define AL_MASTER_CLOCK 13
+#define AL_CRYSTAL_MCLK_TYPE 1
+
+// Sample formats
+#define AL_SAMPFMT_TWOSCOMP 1
+#define AL_SAMPFMT_FLOAT 32
+#define AL_SAMPFMT_DOUBLE 64
+
+// Error codes returned by oserror()
+#define AL_BAD_CONFIG 1
+#define AL_BAD_PORT 2
+#define AL_BAD_RESOURCE 3
+#define AL_BAD_PARAM 4
+#define AL_BAD_CHANNELS 5
+#define AL_BAD_QSIZE 6
+#define AL_BAD_NO_PORTS 7
+#define AL_BAD_OUT_OF_MEM 8
+#define AL_BAD_SAMPFMT 9
+#define AL_BAD_FLOATMAX 10
+
+int oserror(void);
+const char* alGetErrorString(int error);
+
+int alQueryValues(int resource, int param, ALvalue* values, int count, ALpv* quals, int qual_count);
+int alGetParamInfo(int resource, int param, ALparamInfo* info);
+int alSetParams(int resource, ALpv* pvs, int count);
+long long alDoubleToFixed(double value);
+double alFixedToDouble(long long value);
+
+ALconfig alNewConfig(void);
+int alFreeConfig(ALconfig config);
+int alSetChannels(ALconfig config, int channels);
+int alSetQueueSize(ALconfig config, int frames);
+// Only AL_SAMPFMT_FLOAT is supported; samples pass through unscaled
+int alSetSampFmt(ALconfig config, int format);
+int alSetFloatMax(ALconfig config, double max);
+
+ALport alOpenPort(const char* name, const char* mode, ALconfig config);
+int alClosePort(ALport port);
+int alWriteFrames(ALport port, void* buffer, int frames);
+int alReadFrames(ALport port, void* buffer, int frames);
+int alZeroFrames(ALport port, int frames);
+int alGetFilled(ALport port);
+int alGetFillable(ALport port);
+
+// Simulation controls
+// Delay from output to input in frames; fractions are interpolated.
+// Defaults to the IRIX_AUDIO_SIM_DELAY environment variable, or 0.
+void irix_audio_sim_set_delay(double frames);
+double irix_audio_sim_get_delay(void);
+// Run the output clock ppm parts per million faster than the input clock
+// (negative: slower). Defaults to 0, one shared clock.
+void irix_audio_sim_set_rate_skew(double ppm);
+// Output underflows and input overflows since the device started
+unsigned long irix_audio_sim_get_xruns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IRIX_AUDIO_SIM_H
@@ -0,0 +1,422 @@
+// IRIX Audio Library - I/O timing trace
+// A flight recorder for stream I/O: every read/write call appends one
+// fixed-size record (entry time, time spent, frames requested and
+// transferred, queue fill at entry) to a preallocated ring. Only the I/O
+// thread writes the ring. Sampling the fill costs an alGetFilled per call,
+// so it can be thinned out or turned off; xruns are only seen on sampled
+// calls. An xrun keeps recording for a few more calls,
+// then freezes the ring for a dumper thread that writes it to disk, so
+// the audio thread never does file I/O.
+//
+// Trace files are big-endian so traces taken on IRIX replay on other
+// hosts (see audio_trace_replay.c).
+
+#include "irix_audio.h"
+#include "irix_audio_internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRACE_MAGIC 0x49415452      // "IATR"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 32
+#define TRACE_RECORD_SIZE 32
+#define TRACE_POLL_NSEC 10000000    // Dumper thread poll interval
+
+struct IrixAudioTrace {
+    IrixAudioStream* stream;        // NULL once detached
+    IrixAudioTraceParams params;
+    IrixAudioTraceRecord* ring;
+    int queue_size;
+
+    // Stream shape for the file header, kept past the stream's close
+    IrixAudioMode mode;
+    int sample_rate;
+    int channels;
+    int buffer_size;
+    long long origin;               // Time of open; records are relative to it
+
+    // Written by the I/O thread
+    unsigned long count;            // Records written since open
+    unsigned long fill_calls;       // Calls since the last fill sample
+    int seen_write;                 // Output has been written once
+    int post_remaining;             // Records still to keep after an xrun
+    volatile int busy;              // Inside a record update
+
+    // Shared with readers of the ring
+    volatile int frozen;            // Recording suspended for a dump
+    volatile int dump_pending;      // Xrun capture complete, waiting for the dumper
+    volatile int closing;
+    pthread_t dumper;
+    int has_dumper;
+    pthread_mutex_t dump_mutex;     // Serializes dumps
+
+    IrixAudioTraceStats stats;
+};
+
+static long long trace_now(void) {
+    struct timespec ts;
+
+#ifdef __sgi
+    clock_gettime(CLOCK_SGI_CYCLE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void put_u16(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)(v >> 8);
+    p[1] = (unsigned char)v;
+}
+
+static void put_u32(unsigned char* p, unsigned long v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static unsigned int get_u16(const unsigned char* p) {
+    return ((unsigned int)p[0] << 8) | p[1];
+}
+
+static unsigned long get_u32(const unsigned char* p) {
+    return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) |
+           ((unsigned long)p[2] << 8) | p[3];
+}
+
+int irix_audio_trace_fill(IrixAudioTrace* trace) {
+    if (trace->params.fill_interval < 0) return -1;
+    if (trace->fill_calls++ % trace->params.fill_interval != 0) return -1;
+    return alGetFilled(trace->stream->port);
+}
+
+// Start of an I/O call; fill is the queue fill at entry, or -1 if unknown
+void irix_audio_trace_begin(IrixAudioTrace* trace, IrixAudioTraceMark* mark, int fill) {
+    mark->fill = fill;
+    mark->start = trace_now();
+}
+
+// End of an I/O call: append a record
+void irix_audio_trace_end(IrixAudioTrace* trace, IrixAudioTraceMark* mark, int op,
+                          int requested, int transferred) {
+    long long end = trace_now();
+    IrixAudioTraceRecord* record;
+    int flags = 0;
+
+    if (op == IRIX_AUDIO_TRACE_WRITE || op == IRIX_AUDIO_TRACE_ZERO) {
+        if (mark->fill == 0 && trace->seen_write) flags |= IRIX_AUDIO_TRACE_XRUN;
+        trace->seen_write = 1;
+    } else if (op == IRIX_AUDIO_TRACE_READ) {
+        if (trace->queue_size > 0 && mark->fill >= trace->queue_size) flags |= IRIX_AUDIO_TRACE_XRUN;
+    }
+    if (transferred < 0) flags |= IRIX_AUDIO_TRACE_ERROR;
+
+    // Pairs with the frozen/busy handshake in trace_freeze
+    trace->busy = 1;
+    IRIX_AUDIO_BARRIER();
+    if (trace->frozen) {
+        trace->stats.records_skipped++;
+        IRIX_AUDIO_BARRIER();
+        trace->busy = 0;
+        return;
+    }
+
+    record = &trace->ring[trace->count % trace->params.records];
+    record->time_ns = mark->start - trace->origin;
+    record->duration_ns = (end - mark->start > 0x7fffffffLL) ? 0x7fffffff : (int)(end - mark->start);
+    record->frames_requested = requested;
+    record->frames_transferred = transferred;
+    record->fill = mark->fill;
+    record->op = op;
+    record->flags = flags;
+    trace->count++;
+    trace->stats.records++;
+
+    if (flags & IRIX_AUDIO_TRACE_XRUN) {
+        trace->stats.xruns++;
+        if (trace->has_dumper && trace->post_remaining == 0) {
+            trace->post_remaining = trace->params.post_xrun_records + 1;
+        }
+    }
+    // After an xrun, keep the following calls and then hand over the ring
+    if (trace->post_remaining > 0 && --trace->post_remaining == 0) {
+        trace->frozen = 1;
+        IRIX_AUDIO_BARRIER();
+        trace->dump_pending = 1;
+    }
+
+    IRIX_AUDIO_BARRIER();
+    trace->busy = 0;
+}
+
+void irix_audio_trace_rearm(IrixAudioTrace* trace) {
+    trace->seen_write = 0;
+}
+
+// Stop the I/O thread from writing the ring and wait for a record in progress
+static void trace_freeze(IrixAudioTrace* trace) {
+    struct timespec idle;
+
+    idle.tv_sec = 0;
+    idle.tv_nsec = 100000;
+    trace->frozen = 1;
+    IRIX_AUDIO_BARRIER();
+    while (trace->busy) {
+        nanosleep(&idle, NULL);
+    }
+}
+
+// Write the ring, oldest record first; the ring must be frozen
+static int trace_write_file(IrixAudioTrace* trace, const char* path) {
+    unsigned char header[TRACE_HEADER_SIZE];
+    unsigned char bytes[TRACE_RECORD_SIZE];
+    unsigned long records = trace->count;
+    unsigned long first, i;
+    FILE* file;
+
+    if (records > (unsigned long)trace->params.records) records = trace->params.records;
+    first = trace->count - records;
+
+    file = fopen(path, "wb");
+    if (!file) {
+        irix_audio_set_error("Cannot open trace file: %s", path);
+        return -1;
+    }
+
+    memset(header, 0, sizeof(header));
+    put_u32(header, TRACE_MAGIC);
+    put_u16(header + 4, TRACE_VERSION);
+    put_u16(header + 6, trace->mode);
+    put_u32(header + 8, trace->sample_rate);
+    put_u32(header + 12, trace->channels);
+    put_u32(header + 16, trace->queue_size);
+    put_u32(header + 20, trace->buffer_size);
+    put_u32(header + 24, records);
+    put_u32(header + 28, trace->count - records);
+    fwrite(header, 1, sizeof(header), file);
+
+    for (i = 0; i < records; i++) {
+        const IrixAudioTraceRecord* r = &trace->ring[(first + i) % trace->params.records];
+        unsigned long long t = (unsigned long long)r->time_ns;
+        memset(bytes, 0, sizeof(bytes));
+        put_u32(bytes, (unsigned long)(t >> 32));
+        put_u32(bytes + 4, (unsigned long)t);
+        put_u32(bytes + 8, r->duration_ns);
+        put_u32(bytes + 12, r->frames_requested);
+        put_u32(bytes + 16, r->frames_transferred);
+        put_u32(bytes + 20, r->fill);
+        put_u16(bytes + 24, r->op);
+        put_u16(bytes + 26, r->flags);
+        fwrite(bytes, 1, sizeof(bytes), file);
+    }
+
+    if (ferror(file)) {
+        irix_audio_set_error("Error writing trace file: %s", path);
+        fclose(file);
+        return -1;
+    }
+    if (fclose(file) != 0) {
+        irix_audio_set_error("Error writing trace file: %s", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Dump the records collected after an xrun, then resume recording
+static void* trace_dumper(void* arg) {
+    IrixAudioTrace* trace = (IrixAudioTrace*)arg;
+    struct timespec idle;
+    char path[1024];
+
+    idle.tv_sec = 0;
+    idle.tv_nsec = TRACE_POLL_NSEC;
+    while (!trace->closing) {
+        if (!trace->dump_pending) {
+            nanosleep(&idle, NULL);
+            continue;
+        }
+        pthread_mutex_lock(&trace->dump_mutex);
+        trace_freeze(trace);
+        snprintf(path, sizeof(path), "%s.%lu", trace->params.xrun_path, trace->stats.dumps + 1);
+        if (trace_write_file(trace, path) == 0) trace->stats.dumps++;
+        trace->dump_pending = 0;
+        IRIX_AUDIO_BARRIER();
+        trace->frozen = 0;
+        pthread_mutex_unlock(&trace->dump_mutex);
+    }
+    return NULL;
+}
+
+// Start tracing a stream's I/O
+IrixAudioTrace* irix_audio_trace_open(IrixAudioStream* stream, IrixAudioTraceParams* params) {
+    IrixAudioTrace* trace;
+    int fillable;
+
+    if (!stream || !stream->port) {
+        irix_audio_set_error("Invalid stream");
+        return NULL;
+    }
+    if (stream->trace) {
+        irix_audio_set_error("Stream is already traced");
+        return NULL;
+    }
+
+    trace = calloc(1, sizeof(IrixAudioTrace));
+    if (!trace) {
+        irix_audio_set_error("Cannot allocate trace");
+        return NULL;
+    }
+    if (params) trace->params = *params;
+    if (trace->params.records <= 0) trace->params.records = 4096;
+    if (trace->params.post_xrun_records <= 0) trace->params.post_xrun_records = 64;
+    if (trace->params.fill_interval == 0) trace->params.fill_interval = 1;
+    if (trace->params.post_xrun_records >= trace->params.records) {
+        trace->params.post_xrun_records = trace->params.records / 2;
+    }
+    trace->stream = stream;
+    trace->mode = stream->mode;
+    trace->sample_rate = stream->sample_rate;
+    trace->channels = stream->channels;
+    trace->buffer_size = stream->buffer_size;
+
+    trace->ring = calloc(trace->params.records, sizeof(IrixAudioTraceRecord));
+    if (!trace->ring) {
+        irix_audio_set_error("Cannot allocate trace ring");
+        free(trace);
+        return NULL;
+    }
+
+    // Filled plus fillable is the port's queue size
+    fillable = alGetFillable(stream->port);
+    trace->queue_size = (fillable >= 0) ? fillable + alGetFilled(stream->port) : 0;
+
+    pthread_mutex_init(&trace->dump_mutex, NULL);
+    if (trace->params.xrun_path) {
+        if (pthread_create(&trace->dumper, NULL, trace_dumper, trace) != 0) {
+            irix_audio_set_error("Cannot start trace dump thread");
+            pthread_mutex_destroy(&trace->dump_mutex);
+            free(trace->ring);
+            free(trace);
+            return NULL;
+        }
+        trace->has_dumper = 1;
+    }
+
+    trace->origin = trace_now();
+    stream->trace = trace;
+    return trace;
+}
+
+// Write the ring to a file now; recording pauses while it is written
+int irix_audio_trace_dump(IrixAudioTrace* trace, const char* path) {
+    int result;
+
+    if (!trace || !path) {
+        irix_audio_set_error("Invalid trace");
+        return -1;
+    }
+
+    pthread_mutex_lock(&trace->dump_mutex);
+    trace_freeze(trace);
+    result = trace_write_file(trace, path);
+    if (result == 0) trace->stats.dumps++;
+    IRIX_AUDIO_BARRIER();
+    if (!trace->dump_pending) trace->frozen = 0;
+    pthread_mutex_unlock(&trace->dump_mutex);
+    return result;
+}
+
+int irix_audio_trace_get_stats(IrixAudioTrace* trace, IrixAudioTraceStats* stats) {
+    if (!trace || !stats) {
+        irix_audio_set_error("Invalid trace");
+        return -1;
+    }
+    *stats = trace->stats;
+    return 0;
+}
+
+// Unhook the trace from its stream and stop the dumper; the records,
+// statistics and irix_audio_trace_dump stay usable
+void irix_audio_trace_detach(IrixAudioTrace* trace) {
+    if (!trace->stream) return;
+
+    trace->stream->trace = NULL;
+    trace->stream = NULL;
+    trace->closing = 1;
+    if (trace->has_dumper) pthread_join(trace->dumper, NULL);
+    trace->has_dumper = 0;
+}
+
+// Stop tracing; call from the I/O thread or once I/O has stopped
+void irix_audio_trace_close(IrixAudioTrace* trace) {
+    if (!trace) return;
+
+    irix_audio_trace_detach(trace);
+    pthread_mutex_destroy(&trace->dump_mutex);
+    free(trace->ring);
+    free(trace);
+}
+
+// Read a trace file; the records are returned in one block to free()
+IrixAudioTraceRecord* irix_audio_trace_load(const char* path, IrixAudioTraceInfo* info) {
+    unsigned char header[TRACE_HEADER_SIZE];
+    unsigned char bytes[TRACE_RECORD_SIZE];
+    IrixAudioTraceRecord* records;
+    FILE* file;
+    unsigned long i;
+
+    if (!path || !info) {
+        irix_audio_set_error("Invalid trace file arguments");
+        return NULL;
+    }
+
+    file = fopen(path, "rb");
+    if (!file) {
+        irix_audio_set_error("Cannot open trace file: %s", path);
+        return NULL;
+    }
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        get_u32(header) != TRACE_MAGIC || get_u16(header + 4) != TRACE_VERSION) {
+        irix_audio_set_error("Not a trace file: %s", path);
+        fclose(file);
+        return NULL;
+    }
+
+    info->mode = (IrixAudioMode)get_u16(header + 6);
+    info->sample_rate = (int)get_u32(header + 8);
+    info->channels = (int)get_u32(header + 12);
+    info->queue_size = (int)get_u32(header + 16);
+    info->buffer_size = (int)get_u32(header + 20);
+    info->records = (int)get_u32(header + 24);
+    info->records_lost = get_u32(header + 28);
+
+    records = malloc((info->records > 0 ? info->records : 1) * sizeof(IrixAudioTraceRecord));
+    if (!records) {
+        irix_audio_set_error("Cannot allocate trace records");
+        fclose(file);
+        return NULL;
+    }
+    for (i = 0; i < (unsigned long)info->records; i++) {
+        IrixAudioTraceRecord* r = &records[i];
+        if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) {
+            irix_audio_set_error("Truncated trace file: %s", path);
+            free(records);
+            fclose(file);
+            return NULL;
+        }
+        r->time_ns = (long long)(((unsigned long long)get_u32(bytes) << 32) | get_u32(bytes + 4));
+        r->duration_ns = (int)get_u32(bytes + 8);
+        r->frames_requested = (int)get_u32(bytes + 12);
+        r->frames_transferred = (int)get_u32(bytes + 16);
+        r->fill = (int)get_u32(bytes + 20);
+        r->op = (int)get_u16(bytes + 24);
+        r->flags = (int)get_u16(bytes + 26);
+    }
+
+    fclose(file);
+    return records;
+}